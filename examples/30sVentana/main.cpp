@@ -66,7 +66,7 @@ void setup() {
     // Sin límite fijo: dejamos que update() cierre por INACTIVIDAD.
     while (wifiManager.isPortalActive()) {
       wifiManager.update();   // sirve HTTP/DNS y gestiona timeout
-      // Si el usuario guarda credenciales (/save), el equipo se reinicia.
+      // Si el usuario guarda credenciales (/save) y conectan, el portal se cierra solo.
       delay(10);
     }
 
@@ -0,0 +1,158 @@
+/**
+ * AyresWiFiManager - LeaseCost (Arduino IDE friendly)
+ * =====================================================
+ *
+ * Description:
+ * ------------
+ * Measures boot-to-usable-IP with a fresh DHCP exchange against the cached
+ * lease (setLeaseCache). The board reboots itself ROUNDS times per mode,
+ * alternating DHCP and lease boots, and keeps the numbers in RTC memory:
+ *   - boot : millis() when isConnected() first turns true (core boot included)
+ *   - conn : getLastConnectMs(), run() → usable IP (scan, association, IP)
+ * When done it prints min/avg/max per mode and stops.
+ *
+ * The first boot is a warm-up: it connects with DHCP, captures the lease and
+ * waits for SNTP so the lease gets a date (undated leases are not used).
+ *
+ * Usage:
+ * ------
+ *  - Provision the board once through the portal (or keep stored credentials).
+ *  - Open the Serial Monitor at 115200 and let it run (~2 × ROUNDS reboots).
+ *  - Power-cycle the board to start over (RTC memory does not survive it).
+ *
+ * Compatibility:
+ * --------------
+ *  - ESP32 (Arduino core)
+ *  - ESP8266 (Arduino core)
+ *
+ * Author:
+ * -------
+ *  Daniel C. Salgado – AyresNet
+ *
+ * License:
+ * --------
+ *  MIT
+ */
+
+#include <Arduino.h>
+#include <AyresWiFiManager.h>
+
+#if defined(ESP32)
+  #include <WiFi.h>
+  #include <esp_attr.h>
+#elif defined(ESP8266)
+  #include <ESP8266WiFi.h>
+#else
+  #error "Este ejemplo requiere ESP32 o ESP8266"
+#endif
+
+/* ===================== Config del usuario ===================== */
+
+static const uint8_t  ROUNDS       = 10;      // arranques por modo
+static const uint32_t NTP_WAIT_MS  = 15000;   // warm-up: espera de SNTP
+static const uint32_t RTC_BLOCK    = 64;      // ESP8266: lejos de AWM_RTC_BLOCK
+
+/* ============================================================= */
+
+enum : uint8_t { DHCP = 0, LEASE = 1 };
+
+struct Serie {
+  uint32_t n, minMs, maxMs, sumMs;
+  void add(uint32_t ms) {
+    if (!n || ms < minMs) minMs = ms;
+    if (ms > maxMs) maxMs = ms;
+    sumMs += ms; n++;
+  }
+  void print(const char* name) const {
+    Serial.printf("  %-6s %3lu %6lu %6lu %6lu\n", name, (unsigned long)n,
+                  (unsigned long)(n ? minMs : 0), (unsigned long)(n ? sumMs / n : 0),
+                  (unsigned long)maxMs);
+  }
+};
+
+// Sobrevive a ESP.restart() (no a un corte de energía)
+struct Corrida {
+  uint32_t magia;
+  uint32_t arranque;     // 0 = warm-up
+  Serie    boot[2], conn[2];
+};
+static const uint32_t MAGIA = 0x4C434F53;   // "LCOS"
+
+#if defined(ESP32)
+RTC_NOINIT_ATTR static Corrida rtc;
+static void leer(Corrida& c)  { c = rtc; }
+static void guardar(const Corrida& c) { rtc = c; }
+#else
+static void leer(Corrida& c)  { ESP.rtcUserMemoryRead(RTC_BLOCK, (uint32_t*)&c, sizeof(c)); }
+static void guardar(const Corrida& c) { ESP.rtcUserMemoryWrite(RTC_BLOCK, (uint32_t*)&c, sizeof(c)); }
+#endif
+
+AyresWiFiManager wifiManager;
+Corrida corrida;
+uint8_t modo = LEASE;
+
+void setup() {
+  Serial.begin(115200);
+  delay(200);
+
+  leer(corrida);
+  if (corrida.magia != MAGIA) {
+    memset(&corrida, 0, sizeof(corrida));
+    corrida.magia = MAGIA;
+  }
+  if (corrida.arranque > 2 * ROUNDS) {
+    Serial.println("\nLeaseCost: terminado (reset en frío para repetir)");
+    guardar(corrida);
+    return;
+  }
+
+  // Warm-up (0) con lease para capturarlo; luego impares DHCP, pares lease
+  modo = (corrida.arranque == 0 || corrida.arranque % 2 == 0) ? LEASE : DHCP;
+  wifiManager.setLeaseCache(modo == LEASE);
+  wifiManager.begin();
+  wifiManager.run();
+  Serial.printf("\nLeaseCost: arranque %lu/%u (%s)\n", (unsigned long)corrida.arranque,
+                2 * ROUNDS, corrida.arranque == 0 ? "warm-up" : modo == LEASE ? "lease" : "dhcp");
+}
+
+void loop() {
+  static bool medido = false;
+  static uint32_t conectadoAt = 0;
+  wifiManager.update();
+  if (corrida.arranque > 2 * ROUNDS) { delay(100); return; }
+  if (!wifiManager.isConnected()) { delay(1); return; }
+
+  if (!medido) {
+    medido      = true;
+    conectadoAt = millis();
+    const uint32_t conn = wifiManager.getLastConnectMs();
+    Serial.printf("  boot→IP %lu ms · run()→IP %lu ms\n", (unsigned long)conectadoAt, (unsigned long)conn);
+    if (corrida.arranque > 0) {
+      corrida.boot[modo].add(conectadoAt);
+      corrida.conn[modo].add(conn);
+    }
+  }
+
+  // El lease necesita fecha (SNTP) para usarse en el próximo arranque
+  if (corrida.arranque == 0 && !wifiManager.isTimeSynced() &&
+      millis() - conectadoAt < NTP_WAIT_MS) {
+    return;
+  }
+
+  corrida.arranque++;
+  if (corrida.arranque > 2 * ROUNDS) {
+    Serial.printf("\nBoot to usable IP (%u boots per mode, ms)\n", ROUNDS);
+    Serial.printf("  %-6s %3s %6s %6s %6s\n", "", "n", "min", "avg", "max");
+    Serial.println(" boot (core start → isConnected()):");
+    corrida.boot[DHCP].print("dhcp");
+    corrida.boot[LEASE].print("lease");
+    Serial.println(" conn (getLastConnectMs):");
+    corrida.conn[DHCP].print("dhcp");
+    corrida.conn[LEASE].print("lease");
+    guardar(corrida);
+    return;
+  }
+  guardar(corrida);
+  delay(100);   // que salga el log
+  ESP.restart();
+}
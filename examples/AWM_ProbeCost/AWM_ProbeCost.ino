@@ -0,0 +1,156 @@
+/**
+ * AyresWiFiManager - ProbeCost (Arduino IDE friendly)
+ * =====================================================
+ *
+ * Description:
+ * ------------
+ * Measures what each connectivity probe costs on this board, next to the
+ * old blocking check (HTTPClient GET to generate_204):
+ *   - legacy : HTTPClient + WiFiClient, blocking (what hayInternet() used to do)
+ *   - http   : AwmProbe HTTP (raw lwIP, GET until the status line)
+ *   - tcp    : AwmProbe TCP (handshake only)
+ *   - dns    : AwmProbe DNS (lookup only; repeats come from the lwIP cache)
+ *   - ping   : AwmProbe PING (ICMP echo to the gateway)
+ *
+ * For each mode it prints min/avg/max round trip, the longest single loop()
+ * stall while the probe ran and the peak heap taken by the probe.
+ *
+ * Usage:
+ * ------
+ *  - Provision the board once through the portal (or keep stored credentials).
+ *  - Open the Serial Monitor at 115200; the table is printed once connected.
+ *  - Change PROBE_HOST to a LAN host (e.g. tools/probe_standin.py) to factor
+ *    out the WAN.
+ *
+ * Compatibility:
+ * --------------
+ *  - ESP32 (Arduino core)
+ *  - ESP8266 (Arduino core)
+ *
+ * Author:
+ * -------
+ *  Daniel C. Salgado – AyresNet
+ *
+ * License:
+ * --------
+ *  MIT
+ */
+
+#include <Arduino.h>
+#include <AyresWiFiManager.h>
+#include <AWM_Probe.h>
+
+#if defined(ESP32)
+  #include <WiFi.h>
+  #include <HTTPClient.h>
+#elif defined(ESP8266)
+  #include <ESP8266WiFi.h>
+  #include <ESP8266HTTPClient.h>
+#else
+  #error "Este ejemplo requiere ESP32 o ESP8266"
+#endif
+
+/* ===================== Config del usuario ===================== */
+
+static const char*    PROBE_HOST = "clients3.google.com";
+static const uint16_t PROBE_PORT = 80;
+static const char*    PROBE_PATH = "/generate_204";
+static const uint8_t  ROUNDS     = 10;
+static const uint32_t TIMEOUT_MS = 3000;
+
+/* ============================================================= */
+
+AyresWiFiManager wifiManager;
+AwmProbe probe;
+
+struct Stats {
+  uint32_t n = 0, fails = 0, minMs = UINT32_MAX, maxMs = 0, sumMs = 0;
+  uint32_t stallMs = 0, heap = 0;
+  void add(bool ok, uint32_t rtt, uint32_t stall, uint32_t h) {
+    if (stall > stallMs) stallMs = stall;
+    if (h > heap) heap = h;
+    if (!ok) { fails++; return; }
+    n++; sumMs += rtt;
+    if (rtt < minMs) minMs = rtt;
+    if (rtt > maxMs) maxMs = rtt;
+  }
+  void print(const char* name) const {
+    Serial.printf("%-7s %3lu/%-3u %6lu %6lu %6lu %8lu %8lu\n", name,
+                  (unsigned long)n, (unsigned)(n + fails),
+                  (unsigned long)(n ? minMs : 0), (unsigned long)(n ? sumMs / n : 0),
+                  (unsigned long)maxMs, (unsigned long)stallMs, (unsigned long)heap);
+  }
+};
+
+// Lo que hacía hayInternet(): bloquea el loop durante toda la petición
+static void runLegacy(Stats& st) {
+  const uint32_t h0 = ESP.getFreeHeap();
+  const uint32_t t0 = millis();
+  WiFiClient client;
+  HTTPClient http;
+  http.begin(client, String("http://") + PROBE_HOST + ":" + PROBE_PORT + PROBE_PATH);
+#if defined(ESP32)
+  http.setConnectTimeout(TIMEOUT_MS);
+#else
+  http.setTimeout(TIMEOUT_MS);
+#endif
+  const int code = http.GET();
+  const uint32_t h1 = ESP.getFreeHeap();   // con cliente y buffers todavía vivos
+  const uint32_t dt = millis() - t0;
+  http.end();
+  st.add(code == 204, dt, dt, h0 > h1 ? h0 - h1 : 0);
+}
+
+// Una sonda sin bloqueo: el loop sigue girando (update()) mientras espera
+static void runProbe(AwmProbe::Mode mode, Stats& st) {
+  const String host = (mode == AwmProbe::PING) ? WiFi.gatewayIP().toString() : String(PROBE_HOST);
+  uint32_t stall = 0;
+  uint32_t t = millis();
+  probe.start(mode, host.c_str(), PROBE_PORT, PROBE_PATH, TIMEOUT_MS);
+  stall = millis() - t;
+  for (;;) {
+    t = millis();
+    const bool done = probe.poll();
+    wifiManager.update();
+    const uint32_t dt = millis() - t;
+    if (dt > stall) stall = dt;
+    if (done) break;
+    delay(1);
+  }
+  const bool ok = probe.result() == AwmProbe::OK &&
+                  (mode != AwmProbe::HTTP || probe.httpCode() == 204);
+  st.add(ok, probe.rttMs(), stall, probe.heapBytes());
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(200);
+  wifiManager.begin();
+  wifiManager.run();
+}
+
+void loop() {
+  static bool done = false;
+  wifiManager.update();
+  if (done || !wifiManager.isConnected()) { delay(10); return; }
+  done = true;
+  delay(1000);   // que DHCP/ARP/SNTP terminen de asentarse
+
+  Stats legacy, http, tcp, dns, ping;
+  for (uint8_t i = 0; i < ROUNDS; i++) {
+    runLegacy(legacy);
+    runProbe(AwmProbe::HTTP, http);
+    runProbe(AwmProbe::TCP,  tcp);
+    runProbe(AwmProbe::DNS,  dns);
+    runProbe(AwmProbe::PING, ping);
+  }
+
+  Serial.printf("\nProbe cost (%u rounds, host %s, ms / bytes)\n", ROUNDS, PROBE_HOST);
+  Serial.printf("%-7s %7s %6s %6s %6s %8s %8s\n", "mode", "ok/n", "min", "avg", "max", "stall", "heap");
+  legacy.print("legacy");
+  http.print("http");
+  tcp.print("tcp");
+  dns.print("dns");
+  ping.print("ping");
+  Serial.println("stall = longest single loop() iteration; heap = peak bytes taken");
+}
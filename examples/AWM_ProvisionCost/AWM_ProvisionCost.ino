@@ -0,0 +1,169 @@
+/**
+ * AyresWiFiManager - ProvisionCost (Arduino IDE friendly)
+ * =========================================================
+ *
+ * Description:
+ * ------------
+ * Compares time-to-online after submitting credentials in the portal:
+ *   - in-place : current path. /save tests the credentials in AP+STA and
+ *                closes the portal once the STA has an IP; the library reports
+ *                /save → IP in getLastProvisionMs().
+ *   - reboot   : old path, emulated. /save stored the credentials, waited
+ *                1000 ms and called ESP.restart(); after the reboot run()
+ *                blocked in the 2 s button window and then connected.
+ * The reboot path is measured across real restarts: the time spent before
+ * ESP.restart() is kept in RTC memory and added to millis() when isConnected()
+ * turns true on the next boot. ROM/bootloader time is not counted (millis()
+ * starts later), so the reboot figure is a lower bound.
+ *
+ * Both paths connect with the current run() (stored BSSID/channel hint), so the
+ * difference is the restart itself, the old delays and the FS remount.
+ *
+ * Usage:
+ * ------
+ *  - Open the Serial Monitor at 115200. The portal opens on the first boot:
+ *    join the AP and save valid credentials once (that is the in-place sample).
+ *  - The board then reboots itself ROUNDS times and prints min/avg/max.
+ *  - Power-cycle the board to start over (RTC memory does not survive it).
+ *
+ * Compatibility:
+ * --------------
+ *  - ESP32 (Arduino core)
+ *  - ESP8266 (Arduino core)
+ *
+ * Author:
+ * -------
+ *  Daniel C. Salgado – AyresNet
+ *
+ * License:
+ * --------
+ *  MIT
+ */
+
+#include <Arduino.h>
+#include <AyresWiFiManager.h>
+
+#if defined(ESP32)
+  #include <WiFi.h>
+  #include <esp_attr.h>
+#elif defined(ESP8266)
+  #include <ESP8266WiFi.h>
+#else
+  #error "Este ejemplo requiere ESP32 o ESP8266"
+#endif
+
+/* ===================== Config del usuario ===================== */
+
+static const uint8_t  ROUNDS         = 5;      // reinicios del camino viejo
+static const uint32_t OLD_SAVE_MS    = 1000;   // delay() de /save antes de ESP.restart()
+static const uint32_t OLD_WINDOW_MS  = 2000;   // ventana bloqueante del botón en run()
+static const uint32_t RTC_BLOCK      = 64;     // ESP8266: lejos de AWM_RTC_BLOCK
+
+/* ============================================================= */
+
+struct Serie {
+  uint32_t n, minMs, maxMs, sumMs;
+  void add(uint32_t ms) {
+    if (!n || ms < minMs) minMs = ms;
+    if (ms > maxMs) maxMs = ms;
+    sumMs += ms; n++;
+  }
+  void print(const char* name) const {
+    Serial.printf("  %-8s %3lu %6lu %6lu %6lu\n", name, (unsigned long)n,
+                  (unsigned long)(n ? minMs : 0), (unsigned long)(n ? sumMs / n : 0),
+                  (unsigned long)maxMs);
+  }
+};
+
+// Sobrevive a ESP.restart() (no a un corte de energía)
+struct Corrida {
+  uint32_t magia;
+  uint32_t arranque;     // 0 = portal (in-place)
+  uint32_t previoMs;     // /save → ESP.restart() del arranque anterior
+  Serie    inPlace, reboot;
+};
+static const uint32_t MAGIA = 0x50434F53;   // "PCOS"
+
+#if defined(ESP32)
+RTC_NOINIT_ATTR static Corrida rtc;
+static void leer(Corrida& c)  { c = rtc; }
+static void guardar(const Corrida& c) { rtc = c; }
+#else
+static void leer(Corrida& c)  { ESP.rtcUserMemoryRead(RTC_BLOCK, (uint32_t*)&c, sizeof(c)); }
+static void guardar(const Corrida& c) { ESP.rtcUserMemoryWrite(RTC_BLOCK, (uint32_t*)&c, sizeof(c)); }
+#endif
+
+AyresWiFiManager wifiManager;
+Corrida corrida;
+
+// Camino viejo desde el punto en que /save ya guardó: delay + reinicio
+static void reiniciarComoAntes() {
+  const uint32_t t0 = millis();
+  delay(OLD_SAVE_MS);
+  corrida.previoMs = millis() - t0;
+  guardar(corrida);
+  ESP.restart();
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(200);
+
+  leer(corrida);
+  if (corrida.magia != MAGIA) {
+    memset(&corrida, 0, sizeof(corrida));
+    corrida.magia = MAGIA;
+  }
+  if (corrida.arranque > ROUNDS) {
+    Serial.println("\nProvisionCost: terminado (reset en frío para repetir)");
+    guardar(corrida);
+    return;
+  }
+
+  wifiManager.begin();
+  if (corrida.arranque == 0) {
+    Serial.println("\nProvisionCost: guardá credenciales en el portal");
+    wifiManager.openPortal();
+    return;
+  }
+
+  // Arranque tras /save en el camino viejo: ventana del botón bloqueante y run()
+  Serial.printf("\nProvisionCost: reinicio %lu/%u\n", (unsigned long)corrida.arranque, ROUNDS);
+  delay(OLD_WINDOW_MS);
+  wifiManager.run();
+}
+
+void loop() {
+  wifiManager.update();
+  if (corrida.arranque > ROUNDS) { delay(100); return; }
+
+  if (corrida.arranque == 0) {
+    // In-place: la librería mide /save → IP; se espera a que cierre el portal
+    if (!wifiManager.getLastProvisionMs() || wifiManager.isPortalActive()) { delay(1); return; }
+    const uint32_t ms = wifiManager.getLastProvisionMs();
+    Serial.printf("  in-place: /save → IP %lu ms\n", (unsigned long)ms);
+    corrida.inPlace.add(ms);
+    corrida.arranque++;
+    reiniciarComoAntes();
+    return;
+  }
+
+  if (!wifiManager.isConnected()) { delay(1); return; }
+
+  const uint32_t total = corrida.previoMs + millis();
+  Serial.printf("  reboot: /save → IP %lu ms (%lu antes del reinicio)\n",
+                (unsigned long)total, (unsigned long)corrida.previoMs);
+  corrida.reboot.add(total);
+
+  corrida.arranque++;
+  if (corrida.arranque > ROUNDS) {
+    Serial.println("\n/save to usable IP (ms, ROM/bootloader not counted)");
+    Serial.printf("  %-8s %3s %6s %6s %6s\n", "", "n", "min", "avg", "max");
+    corrida.inPlace.print("in-place");
+    corrida.reboot.print("reboot");
+    guardar(corrida);
+    return;
+  }
+  delay(100);   // que salga el log
+  reiniciarComoAntes();
+}
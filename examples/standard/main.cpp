@@ -82,7 +82,8 @@ void setup() {
   // === Inicializa FS/GPIO/WiFi y carga credenciales ===
   wifiManager.begin();
 
-  // Intenta conectar (si conecta hace NTP). Si no, aplicará la política anterior.
+  // Lanza la conexión sin bloquear: update() la completa (NTP si conecta,
+  // política anterior si falla) y atiende la ventana del botón.
   wifiManager.run();
 
   // Autoreconexión del driver + lógica propia de la lib
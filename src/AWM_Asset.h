@@ -0,0 +1,131 @@
+// AWM_Asset.h
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+/*
+ * AyresWiFiManager — envío de assets del portal desde un FS
+ *
+ * El archivo sale por bloques de AWM_STREAM_CHUNK bytes (buffer en stack):
+ * nunca se carga entero en un String, así el pico de heap por request no
+ * depende del tamaño del HTML. Si existe "<path>.gz" y el cliente acepta gzip
+ * se envía esa variante (Content-Encoding: gzip, Vary: Accept-Encoding).
+ * Con cacheable=true agrega ETag (FNV-1a del contenido) + Cache-Control y
+ * responde 304 sin cuerpo si el navegador ya tiene esa versión.
+ *
+ * Qué variantes existen y sus hashes se resuelven una sola vez por path;
+ * clear() lo invalida (p. ej. al cambiar el prefijo de rutas).
+ *
+ * Plantilla sobre el servidor y el FS para poder probarlo en la PC
+ * (test/host) con dobles; en la placa se usa con WebServer y LittleFS:
+ *   AwmAssets assets;
+ *   assets.send(server, LittleFS, "/index.html", "text/html", 200, true);
+ */
+
+// Buffer fijo (bytes, en stack) con el que se envían las páginas del portal
+// desde LittleFS. Acota el pico de heap por request sin importar el tamaño del HTML.
+#ifndef AWM_STREAM_CHUNK
+  #define AWM_STREAM_CHUNK 1024
+#endif
+
+// max-age (segundos) del Cache-Control de las páginas del portal. Con 0 el
+// navegador revalida cada vez y recibe 304 (ETag) si nada cambió.
+#ifndef AWM_ASSET_MAX_AGE
+  #define AWM_ASSET_MAX_AGE 0
+#endif
+
+class AwmAssets {
+public:
+  template <class Server>
+  static bool acceptsGzip(Server& server) {
+    return server.header("Accept-Encoding").indexOf("gzip") >= 0;
+  }
+
+  // Agrega ETag + Cache-Control de asset estático. Si el navegador ya tiene esa
+  // versión (If-None-Match), responde 304 sin cuerpo y devuelve true.
+  template <class Server>
+  static bool notModified(Server& server, uint32_t hash) {
+    char etag[12];
+    snprintf(etag, sizeof(etag), "\"%08lx\"", (unsigned long)hash);
+
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "public, max-age=" + String((unsigned long)AWM_ASSET_MAX_AGE));
+
+    if (server.header("If-None-Match").indexOf(etag) < 0) return false;
+    server.send(304, "text/html", "");
+    return true;
+  }
+
+  // FNV-1a 32 bits sobre el contenido; se rebobina el archivo al terminar.
+  template <class File>
+  static uint32_t hash(File& file) {
+    uint32_t h = 2166136261UL;
+    uint8_t buf[AWM_STREAM_CHUNK];
+    while (file.available()) {
+      size_t n = file.read(buf, sizeof(buf));
+      if (n == 0) break;
+      for (size_t i = 0; i < n; ++i) { h ^= buf[i]; h *= 16777619UL; }
+    }
+    file.seek(0);
+    return h ? h : 1;  // 0 = "sin calcular"
+  }
+
+  // Devuelve false (sin enviar nada) si el archivo no existe o no se puede abrir.
+  template <class Server, class Fs>
+  bool send(Server& server, Fs& fs, const String& path, const char* contentType,
+            int code = 200, bool cacheable = false) {
+    Info& info = infoDe(fs, path);
+    bool gz = info.hasGz && acceptsGzip(server);
+    auto file = fs.open(gz ? path + ".gz" : path, "r");
+    if (!file && gz) {
+      gz = false;
+      file = fs.open(path, "r");
+    }
+    if (!file) return false;
+    if (file.isDirectory()) { file.close(); return false; }
+
+    if (info.hasGz) server.sendHeader("Vary", "Accept-Encoding");
+    if (cacheable) {
+      uint32_t& h = gz ? info.hashGz : info.hashPlain;
+      if (h == 0) h = hash(file);
+      if (notModified(server, h)) { file.close(); return true; }
+    }
+    if (gz) server.sendHeader("Content-Encoding", "gzip");
+    server.setContentLength(file.size());
+    server.send(code, contentType, "");
+
+    uint8_t buf[AWM_STREAM_CHUNK];
+    while (file.available()) {
+      size_t n = file.read(buf, sizeof(buf));
+      if (n == 0) break;
+      server.sendContent(reinterpret_cast<const char*>(buf), n);
+    }
+    file.close();
+    return true;
+  }
+
+  void clear() { _cache.clear(); }
+
+private:
+  struct Info {
+    String   path;
+    bool     hasGz     = false;
+    uint32_t hashPlain = 0;    // 0 = aún no calculado
+    uint32_t hashGz    = 0;
+  };
+
+  // ¿Hay "<path>.gz"? se consulta al FS una sola vez por path.
+  template <class Fs>
+  Info& infoDe(Fs& fs, const String& path) {
+    for (auto& a : _cache) {
+      if (a.path == path) return a;
+    }
+    Info info;
+    info.path  = path;
+    info.hasGz = fs.exists(path + ".gz");
+    _cache.push_back(info);
+    return _cache.back();
+  }
+
+  std::vector<Info> _cache;
+};
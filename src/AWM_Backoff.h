@@ -0,0 +1,70 @@
+// AWM_Backoff.h
+#pragma once
+#include <Arduino.h>
+
+/*
+ * AyresWiFiManager — backoff exponencial con jitter sembrado por MAC
+ *
+ * La espera n-ésima es d = min(cap, base · mult^n) y se sortea dentro de
+ * [d · (1 − jitter), d]. El generador (xorshift32) se siembra con un hash
+ * FNV-1a de la MAC: cada equipo sortea distinto (aun con MACs consecutivas)
+ * y siempre igual tras un reinicio. Cuando el router de un sitio reinicia,
+ * los equipos que lo perdieron a la vez no reintentan en el mismo instante.
+ *
+ * tools/backoff_sim.py reproduce este cálculo (mantenerlos iguales) y simula
+ * cómo se reparten los intentos de N equipos.
+ *
+ * Uso:
+ *   AwmBackoff b;  b.config(10000, 2.0f, 300000, 50);  b.seed(mac);
+ *   b.next();   // 5..10 s, luego 10..20 s, 20..40 s, … hasta 150..300 s
+ *   b.reset();  // al reconectar
+ */
+
+class AwmBackoff {
+public:
+  void config(uint32_t baseMs, float mult, uint32_t capMs, uint8_t jitterPct) {
+    _base   = baseMs ? baseMs : 1;
+    _mult   = (mult < 1.0f) ? 1.0f : mult;
+    _cap    = (capMs < _base) ? _base : capMs;
+    _jitter = (jitterPct > 100) ? 100 : jitterPct;
+    reset();
+  }
+
+  void seed(const uint8_t mac[6]) {
+    uint32_t h = 2166136261u;                 // FNV-1a
+    for (int i = 0; i < 6; i++) h = (h ^ mac[i]) * 16777619u;
+    _rnd = h ? h : 0x9E3779B9u;               // xorshift no admite semilla 0
+  }
+
+  // Espera antes del próximo intento (ms) y avanza un escalón.
+  uint32_t next() {
+    const uint32_t d = _cur;
+    const float sig  = (float)d * _mult;
+    _cur = (sig >= (float)_cap) ? _cap : (uint32_t)sig;
+    if (_n < 255) _n++;
+
+    const uint32_t j = (uint32_t)((uint64_t)d * _jitter / 100);
+    return j ? d - j + aleatorio() % (j + 1) : d;
+  }
+
+  void reset() { _cur = _base; _n = 0; }
+  uint8_t  steps()  const { return _n; }
+  uint32_t baseMs() const { return _base; }
+  uint32_t capMs()  const { return _cap; }
+
+private:
+  uint32_t aleatorio() {
+    _rnd ^= _rnd << 13;
+    _rnd ^= _rnd >> 17;
+    _rnd ^= _rnd << 5;
+    return _rnd;
+  }
+
+  uint32_t _base   = 10000;
+  float    _mult   = 2.0f;
+  uint32_t _cap    = 300000;
+  uint8_t  _jitter = 50;
+  uint32_t _cur    = 10000;   // escalón actual sin jitter
+  uint8_t  _n      = 0;
+  uint32_t _rnd    = 0x9E3779B9u;
+};
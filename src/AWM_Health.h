@@ -0,0 +1,170 @@
+// AWM_Health.h
+#pragma once
+#include <Arduino.h>
+
+/*
+ * AyresWiFiManager — monitor de salud del enlace
+ *
+ * Una muestra cada N segundos en un anillo fijo (AWM_HEALTH_SAMPLES, sin heap):
+ * RSSI crudo y suavizado (EWMA, α = 1/4), caídas y la reconexión más larga
+ * desde la muestra anterior, y el rtt de la última sonda de Internet. Los
+ * eventos (disconnect/reconnect/probe) solo suman contadores; el puntaje se
+ * recalcula al tomar la muestra, así quality() es O(1).
+ *
+ * Puntaje 0..100:
+ *   RSSI suavizado   -90 dBm → 0 … -50 dBm → 100
+ *   − 15 por caída en la ventana del anillo
+ *   − hasta 30 por latencia (promedio de sondas: 150 ms → 0, ≥1050 ms → 30)
+ *   sin IP → 0; portal cautivo → ≤10; sin Internet → ≤25
+ *
+ * Uso:
+ *   AwmHealth h;
+ *   h.disconnect(); h.reconnect(ms); h.probe(ok, rttMs);   // al ocurrir
+ *   h.sample(millis(), WiFi.RSSI(), AwmHealth::F_LINK | AwmHealth::F_NET_OK);
+ *   h.quality();
+ */
+
+// Muestras del anillo (16 bytes c/u). Con el período por defecto (5 s),
+// 32 muestras ≈ 2:40 min de historia.
+#ifndef AWM_HEALTH_SAMPLES
+  #define AWM_HEALTH_SAMPLES 32
+#endif
+static_assert(AWM_HEALTH_SAMPLES >= 2 && AWM_HEALTH_SAMPLES <= 255, "AWM_HEALTH_SAMPLES: 2..255");
+
+class AwmHealth {
+public:
+  enum : uint8_t { F_LINK = 1, F_NET_OK = 2, F_NET_MAL = 4, F_CAPTIVE = 8 };
+
+  struct Sample {
+    uint32_t atS;           // segundos desde el arranque
+    int8_t   rssi;          // dBm (0 = sin enlace)
+    int8_t   rssiAvg;       // EWMA en dBm
+    uint8_t  disconnects;   // caídas desde la muestra anterior
+    uint8_t  flags;         // F_*
+    uint16_t probeMs;       // rtt de la última sonda OK en el intervalo (0 = ninguna)
+    uint8_t  probeFails;
+    uint8_t  quality;
+    uint32_t reconnectMs;   // reconexión más larga terminada en el intervalo (0 = ninguna)
+  };
+
+  struct Report {
+    uint8_t  quality       = 0;
+    uint8_t  samples       = 0;
+    int8_t   rssiAvg       = 0;    // EWMA actual
+    int8_t   rssiTrend     = 0;    // EWMA ahora − EWMA en la muestra más vieja (dB)
+    uint16_t disconnects   = 0;    // en la ventana del anillo
+    uint32_t disconnectsTotal = 0; // desde el arranque
+    uint32_t reconnectMaxMs = 0;   // en la ventana
+    uint32_t reconnectAvgMs = 0;
+    uint16_t probeAvgMs    = 0;    // en la ventana
+    uint16_t probeMaxMs    = 0;
+    uint16_t probeFails    = 0;
+  };
+
+  void disconnect() {
+    if (_disc < 255) _disc++;
+    _discTotal++;
+  }
+  void reconnect(uint32_t ms) { if (ms > _recMs) _recMs = ms; }
+  void probe(bool ok, uint32_t rttMs) {
+    if (ok) _probeMs = (uint16_t)(rttMs >= 65535 ? 65535 : (rttMs ? rttMs : 1));
+    else if (_probeFails < 255) _probeFails++;
+  }
+
+  void sample(uint32_t nowMs, int8_t rssi, uint8_t flags) {
+    if (flags & F_LINK && rssi < 0) {
+      const int16_t x = (int16_t)rssi * 16;
+      _ewma16 = _ewmaOk ? (int16_t)(_ewma16 + (x - _ewma16) / 4) : x;
+      _ewmaOk = true;
+    }
+    Sample& s = _ring[_head];
+    s.atS         = nowMs / 1000;
+    s.rssi        = (flags & F_LINK) ? rssi : 0;
+    s.rssiAvg     = rssiAvg();
+    s.disconnects = _disc;
+    s.flags       = flags;
+    s.probeMs     = _probeMs;
+    s.probeFails  = _probeFails;
+    s.reconnectMs = _recMs;
+    _head = (_head + 1) % AWM_HEALTH_SAMPLES;
+    if (_n < AWM_HEALTH_SAMPLES) _n++;
+    _disc = 0; _recMs = 0; _probeMs = 0; _probeFails = 0;
+
+    const Report r = calcular();
+    int q = 0;
+    if (flags & F_LINK) {
+      q = (r.rssiAvg + 90) * 100 / 40;
+      q = q < 0 ? 0 : (q > 100 ? 100 : q);
+      q -= 15 * r.disconnects;
+      if (r.probeAvgMs > 150) {
+        const int lat = (r.probeAvgMs - 150) / 30;
+        q -= lat > 30 ? 30 : lat;
+      }
+      if (flags & F_CAPTIVE)      q = q > 10 ? 10 : q;
+      else if (flags & F_NET_MAL) q = q > 25 ? 25 : q;
+      if (q < 0) q = 0;
+    }
+    s.quality = _quality = (uint8_t)q;
+  }
+
+  uint8_t quality() const { return _quality; }
+  int8_t  rssiAvg() const { return _ewmaOk ? (int8_t)((_ewma16 - 8) / 16) : 0; }
+
+  Report report() const {
+    Report r = calcular();
+    r.quality = _quality;
+    return r;
+  }
+
+  // Copia hasta max muestras, de la más vieja a la más nueva.
+  uint8_t copy(Sample* out, uint8_t max) const {
+    const uint8_t n = _n < max ? _n : max;
+    for (uint8_t i = 0; i < n; i++) out[i] = _ring[indice(_n - n + i)];
+    return n;
+  }
+
+private:
+  // i = 0 → la más vieja del anillo
+  uint8_t indice(uint8_t i) const {
+    return (uint8_t)((_head + AWM_HEALTH_SAMPLES - _n + i) % AWM_HEALTH_SAMPLES);
+  }
+
+  Report calcular() const {
+    Report r;
+    r.samples = _n;
+    r.rssiAvg = rssiAvg();
+    r.disconnectsTotal = _discTotal;
+    uint32_t probeSum = 0, recSum = 0;
+    uint16_t probes = 0, recs = 0;
+    int8_t viejo = 0;
+    for (uint8_t i = 0; i < _n; i++) {
+      const Sample& s = _ring[indice(i)];
+      if (!viejo && s.rssiAvg) viejo = s.rssiAvg;
+      r.disconnects += s.disconnects;
+      r.probeFails  += s.probeFails;
+      if (s.probeMs) {
+        probeSum += s.probeMs; probes++;
+        if (s.probeMs > r.probeMaxMs) r.probeMaxMs = s.probeMs;
+      }
+      if (s.reconnectMs) {
+        recSum += s.reconnectMs; recs++;
+        if (s.reconnectMs > r.reconnectMaxMs) r.reconnectMaxMs = s.reconnectMs;
+      }
+    }
+    r.probeAvgMs     = probes ? (uint16_t)(probeSum / probes) : 0;
+    r.reconnectAvgMs = recs ? recSum / recs : 0;
+    r.rssiTrend      = (viejo && r.rssiAvg) ? (int8_t)(r.rssiAvg - viejo) : 0;
+    return r;
+  }
+
+  Sample   _ring[AWM_HEALTH_SAMPLES] = {};
+  uint8_t  _head = 0, _n = 0;
+  int16_t  _ewma16 = 0;         // dBm × 16
+  bool     _ewmaOk = false;
+  uint8_t  _quality = 0;
+  // acumulado desde la última muestra
+  uint8_t  _disc = 0, _probeFails = 0;
+  uint16_t _probeMs = 0;
+  uint32_t _recMs = 0;
+  uint32_t _discTotal = 0;
+};
@@ -0,0 +1,71 @@
+// AWM_JsonWriter.h
+#pragma once
+#include <Arduino.h>
+
+/*
+ * AyresWiFiManager — Escritor JSON en streaming
+ *
+ * Arma JSON directamente sobre un buffer fijo y lo vuelca por bloques a un
+ * "sink" (ej.: WebServer::sendContent o un WiFiClient). No usa
+ * DynamicJsonDocument ni String intermedios: el pico de memoria es el buffer.
+ *
+ * Defines:
+ *   AWM_JSON_CHUNK : tamaño del buffer en bytes (default: 256)
+ *
+ * Uso:
+ *   AwmJsonWriter w(sink, ctx);
+ *   w.raw('[');  w.raw("{\"ssid\":");  w.str(ssid);  w.raw(",\"rssi\":");  w.num(rssi);
+ *   w.raw("}]"); w.flush();
+ */
+
+#ifndef AWM_JSON_CHUNK
+#  define AWM_JSON_CHUNK 256
+#endif
+
+class AwmJsonWriter {
+public:
+  typedef void (*Sink)(void* ctx, const char* data, size_t len);
+
+  AwmJsonWriter(Sink sink, void* ctx) : _sink(sink), _ctx(ctx) {}
+  ~AwmJsonWriter() { flush(); }
+
+  void raw(char c) {
+    if (_len == sizeof(_buf)) flush();
+    _buf[_len++] = c;
+  }
+  void raw(const char* s) { while (*s) raw(*s++); }
+
+  // String JSON entre comillas; escapa ", \ y caracteres de control.
+  void str(const char* s) {
+    static const char hex[] = "0123456789abcdef";
+    raw('"');
+    for (; *s; ++s) {
+      const uint8_t c = (uint8_t)*s;
+      if (c == '"' || c == '\\') { raw('\\'); raw((char)c); }
+      else if (c == '\n')        { raw("\\n"); }
+      else if (c == '\r')        { raw("\\r"); }
+      else if (c == '\t')        { raw("\\t"); }
+      else if (c < 0x20)         { raw("\\u00"); raw(hex[c >> 4]); raw(hex[c & 0xF]); }
+      else                       { raw((char)c); }
+    }
+    raw('"');
+  }
+
+  void num(long v) {
+    char tmp[12];
+    snprintf(tmp, sizeof(tmp), "%ld", v);
+    raw(tmp);
+  }
+
+  void boolean(bool v) { raw(v ? "true" : "false"); }
+
+  void flush() {
+    if (_len) { _sink(_ctx, _buf, _len); _len = 0; }
+  }
+
+private:
+  Sink   _sink;
+  void*  _ctx;
+  char   _buf[AWM_JSON_CHUNK];
+  size_t _len = 0;
+};
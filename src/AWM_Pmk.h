@@ -0,0 +1,142 @@
+// AWM_Pmk.h
+#pragma once
+#include <Arduino.h>
+
+/*
+ * AyresWiFiManager — PMK WPA/WPA2-PSK (PBKDF2-HMAC-SHA1)
+ *
+ * Deriva la PMK de 32 bytes que el driver calcula en cada WiFi.begin() con
+ * passphrase: PBKDF2-HMAC-SHA1(passphrase, ssid, 4096 iteraciones). Se hace
+ * una sola vez al guardar; después begin() recibe la PSK en 64 hex y el
+ * driver se saltea el cálculo.
+ *
+ * La derivación es incremental: step(n) hace como mucho n iteraciones, para
+ * repartirla entre vueltas del loop. Cada iteración son dos compresiones
+ * SHA1 (los estados de ipad/opad de la clave se calculan una vez).
+ *
+ * Uso:
+ *   AwmPmk pmk;  pmk.begin(pass, ssid);
+ *   while (!pmk.step(256)) yield();
+ *   char psk[65];  pmk.hex(psk);        // "f42c6f…" → WiFi.begin(ssid, psk)
+ */
+
+class AwmPmk {
+public:
+  static constexpr uint32_t ITERACIONES = 4096;
+
+  void begin(const char* pass, const char* ssid) {
+    uint8_t k[64] = {0};
+    size_t kl = strlen(pass);
+    if (kl > sizeof(k)) kl = sizeof(k);   // WPA: 8..63 caracteres
+    memcpy(k, pass, kl);
+
+    uint8_t pad[64];
+    for (int i = 0; i < 64; i++) pad[i] = k[i] ^ 0x36;
+    inicial(_ipad); compress(_ipad, pad);
+    for (int i = 0; i < 64; i++) pad[i] = k[i] ^ 0x5c;
+    inicial(_opad); compress(_opad, pad);
+
+    _saltLen = strlen(ssid);
+    if (_saltLen > 32) _saltLen = 32;
+    memcpy(_salt, ssid, _saltLen);
+    _bloque = 1;
+    _iter   = 0;
+  }
+
+  // Avanza hasta n iteraciones; true cuando la PMK está completa.
+  bool step(uint32_t n) {
+    while (n-- && !done()) {
+      if (_iter == 0) {
+        // U1 = HMAC(pass, ssid || INT(bloque))
+        uint8_t m[36];
+        memcpy(m, _salt, _saltLen);
+        m[_saltLen] = 0; m[_saltLen + 1] = 0; m[_saltLen + 2] = 0; m[_saltLen + 3] = _bloque;
+        hmac(m, _saltLen + 4, _u);
+        memcpy(_t, _u, sizeof(_t));
+      } else {
+        hmac(_u, sizeof(_u), _u);
+        for (int i = 0; i < 20; i++) _t[i] ^= _u[i];
+      }
+      if (++_iter == ITERACIONES) {
+        const size_t off = (_bloque - 1) * 20;
+        memcpy(_pmk + off, _t, (off + 20 <= 32) ? 20 : 32 - off);
+        _bloque++;
+        _iter = 0;
+      }
+    }
+    return done();
+  }
+
+  bool done() const { return _bloque > 2; }
+  const uint8_t* pmk() const { return _pmk; }
+
+  void hex(char out[65]) const {
+    static const char d[] = "0123456789abcdef";
+    for (int i = 0; i < 32; i++) { out[2*i] = d[_pmk[i] >> 4]; out[2*i + 1] = d[_pmk[i] & 0x0f]; }
+    out[64] = '\0';
+  }
+
+  // true si s ya es una PSK (64 dígitos hex) y no una passphrase.
+  static bool esHex(const char* s) {
+    size_t n = 0;
+    for (; s[n]; n++) if (!isxdigit((unsigned char)s[n])) return false;
+    return n == 64;
+  }
+
+private:
+  static uint32_t rol(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+  static void inicial(uint32_t h[5]) {
+    h[0] = 0x67452301; h[1] = 0xEFCDAB89; h[2] = 0x98BADCFE; h[3] = 0x10325476; h[4] = 0xC3D2E1F0;
+  }
+
+  static void compress(uint32_t h[5], const uint8_t b[64]) {
+    uint32_t w[16];
+    for (int i = 0; i < 16; i++) {
+      w[i] = (uint32_t)b[4*i] << 24 | (uint32_t)b[4*i + 1] << 16 | (uint32_t)b[4*i + 2] << 8 | b[4*i + 3];
+    }
+    uint32_t a = h[0], bb = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      if (i >= 16) {
+        w[i & 15] = rol(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1);
+      }
+      uint32_t f, k;
+      if      (i < 20) { f = (bb & c) | (~bb & d);           k = 0x5A827999; }
+      else if (i < 40) { f = bb ^ c ^ d;                     k = 0x6ED9EBA1; }
+      else if (i < 60) { f = (bb & c) | (bb & d) | (c & d);  k = 0x8F1BBCDC; }
+      else             { f = bb ^ c ^ d;                     k = 0xCA62C1D6; }
+      const uint32_t t = rol(a, 5) + f + e + k + w[i & 15];
+      e = d; d = c; c = rol(bb, 30); bb = a; a = t;
+    }
+    h[0] += a; h[1] += bb; h[2] += c; h[3] += d; h[4] += e;
+  }
+
+  // SHA1 de (bloque de 64 ya absorbido en 'estado') || msg, con msg < 56 bytes.
+  static void cierre(const uint32_t estado[5], const uint8_t* msg, size_t len, uint8_t out[20]) {
+    uint8_t b[64] = {0};
+    memcpy(b, msg, len);
+    b[len] = 0x80;
+    const uint32_t bits = (uint32_t)(64 + len) * 8;
+    b[60] = bits >> 24; b[61] = bits >> 16; b[62] = bits >> 8; b[63] = bits;
+    uint32_t h[5];
+    memcpy(h, estado, sizeof(h));
+    compress(h, b);
+    for (int i = 0; i < 5; i++) {
+      out[4*i] = h[i] >> 24; out[4*i + 1] = h[i] >> 16; out[4*i + 2] = h[i] >> 8; out[4*i + 3] = h[i];
+    }
+  }
+
+  void hmac(const uint8_t* msg, size_t len, uint8_t out[20]) const {
+    uint8_t in[20];
+    cierre(_ipad, msg, len, in);
+    cierre(_opad, in, sizeof(in), out);
+  }
+
+  uint32_t _ipad[5], _opad[5];
+  uint8_t  _salt[32];
+  size_t   _saltLen = 0;
+  uint8_t  _u[20], _t[20];
+  uint8_t  _pmk[32] = {0};
+  uint8_t  _bloque = 3;      // 1..2 en curso; 3 = listo (o sin begin())
+  uint32_t _iter   = 0;
+};
@@ -0,0 +1,323 @@
+// AWM_Probe.h
+#pragma once
+#include <Arduino.h>
+#include <lwip/tcp.h>
+#include <lwip/dns.h>
+#include <lwip/raw.h>
+#include <lwip/icmp.h>
+#include <lwip/ip.h>
+#include <lwip/inet_chksum.h>
+#if defined(ESP32)
+  #include <lwip/tcpip.h>
+  #include <atomic>
+#endif
+
+/*
+ * AyresWiFiManager — sondas de conectividad sin bloqueo (API raw de lwIP)
+ *
+ * Cuatro modos, del más caro al más barato:
+ *   HTTP  GET host:puerto/ruta hasta la línea de estado (DNS + TCP + request)
+ *   TCP   solo el handshake con host:puerto
+ *   DNS   solo la resolución de host
+ *   PING  un echo ICMP a host (típicamente el gateway: prueba la LAN, no Internet)
+ * Cada paso avanza por callbacks de lwIP; el loop solo llama a poll(). Sin
+ * HTTPClient/WiFiClient: nada espera dentro de loop() y de la respuesta HTTP
+ * solo se guardan sus primeros bytes. Al leerlos (o al completar el
+ * handshake en TCP) la conexión se corta con RST: no queda un PCB en TIME_WAIT.
+ *
+ * rttMs() mide la operación que define el modo (consulta DNS, handshake,
+ * GET → línea de estado, echo → reply); totalMs() incluye la resolución.
+ * En DNS, una respuesta del cache de lwIP (TTL del registro) o una IP literal
+ * termina OK con cached() = true y rtt 0: no hubo consulta, así que no prueba
+ * que el resolver conteste. heapBytes() es el pico de heap usado, muestreado
+ * en poll().
+ *
+ * En ESP32 lwIP corre en su propia tarea: lo que toca PCBs entra por
+ * tcpip_callback() y los callbacks solo publican el resultado (atómico). En
+ * ESP8266 lwIP corre en el mismo contexto que loop() y se llama directo.
+ *
+ * Uso:
+ *   AwmProbe p;
+ *   p.start("clients3.google.com", 80, "/generate_204", 3000);
+ *   … en cada vuelta: if (p.poll() && p.result() == AwmProbe::OK) p.httpCode();
+ */
+
+class AwmProbe {
+public:
+  enum Result : uint8_t { IDLE, RUNNING, OK, ERR_DNS, ERR_CONNECT, ERR_TIMEOUT, ERR_REPLY };
+  enum Mode   : uint8_t { HTTP, TCP, DNS, PING };
+
+  static constexpr size_t HOST_MAX = 63;
+  static constexpr size_t RUTA_MAX = 80;
+
+  // Lanza la sonda. false si hay una en curso o si host/ruta no entran.
+  // host puede ser una IP literal: dns_gethostbyname() la resuelve sin consultar.
+  // port y path solo se usan donde aplican (path: HTTP; port: HTTP y TCP).
+  bool start(Mode mode, const char* host, uint16_t port, const char* path, uint32_t timeoutMs) {
+    if (_res == RUNNING) return false;
+    const size_t hl = strlen(host);
+    if (!hl || hl > HOST_MAX || (path && strlen(path) > RUTA_MAX)) return false;
+    memcpy(_host, host, hl + 1);
+    if (mode == HTTP) {
+      _reqLen = (uint16_t)snprintf(_req, sizeof(_req),
+          "GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: AyresWiFiManager\r\nConnection: close\r\n\r\n",
+          path ? path : "/", host);
+    }
+    _modo = mode;
+    _port = port;
+    _timeout = timeoutMs;
+    _code = 0;
+    _tDns = 0; _tMarca = 0; _tFin = 0;
+    _cache = false;
+    _t0 = millis();
+    _heap0 = _heapMin = ESP.getFreeHeap();
+    _gen++;
+    _res = RUNNING;
+    enLwip(arrancarCb);
+    return true;
+  }
+
+  bool start(const char* host, uint16_t port, const char* path, uint32_t timeoutMs) {
+    return start(HTTP, host, port, path, timeoutMs);
+  }
+
+  // true cuando terminó (bien o mal). Vence el timeout si corresponde.
+  bool poll() {
+    if (_res == RUNNING) {
+      const uint32_t h = ESP.getFreeHeap();
+      if (h < _heapMin) _heapMin = h;
+    }
+    if (_res == RUNNING && millis() - _t0 >= _timeout && fijar(ERR_TIMEOUT)) {
+      _tFin = millis();
+      enLwip(cerrarCb);
+    }
+    const uint8_t r = _res;
+    return r != RUNNING && r != IDLE;
+  }
+
+  void cancel() {
+    if (fijar(IDLE)) enLwip(cerrarCb);
+  }
+
+  Result   result()    const { return (Result)(uint8_t)_res; }
+  Mode     mode()      const { return (Mode)_modo; }
+  int      httpCode()  const { return _code; }
+  uint32_t rttMs()     const { return (_tFin && _tMarca) ? _tFin - _tMarca : 0; }
+  uint32_t totalMs()   const { return _tFin ? _tFin - _t0 : 0; }
+  uint32_t dnsMs()     const { return _tDns ? _tDns - _t0 : 0; }
+  bool     resolved()  const { return _tDns != 0; }   // host resuelto (o IP literal)
+  bool     cached()    const { return _cache; }       // resuelto sin consulta (cache de lwIP o IP literal)
+  uint32_t heapBytes() const { return _heap0 > _heapMin ? _heap0 - _heapMin : 0; }
+
+  static const char* nombre(Mode m) {
+    switch (m) {
+      case HTTP: return "http";
+      case TCP:  return "tcp";
+      case DNS:  return "dns";
+      default:   return "ping";
+    }
+  }
+
+  static const char* nombre(Result r) {
+    switch (r) {
+      case OK:          return "ok";
+      case ERR_DNS:     return "dns";
+      case ERR_CONNECT: return "connect";
+      case ERR_TIMEOUT: return "timeout";
+      case ERR_REPLY:   return "reply";
+      default:          return "-";
+    }
+  }
+
+private:
+  enum Fase : uint8_t { F_NADA, F_DNS, F_TCP, F_HTTP, F_PING };
+  static constexpr uint16_t PING_ID    = 0x4157;   // "AW"
+  static constexpr uint16_t PING_DATOS = 16;
+
+  void enLwip(void (*fn)(void*)) {
+#if defined(ESP32)
+    tcpip_callback(fn, this);
+#else
+    fn(this);   // ESP8266: lwIP corre en el mismo contexto que loop()
+#endif
+  }
+
+  // RUNNING → r; false si otro (timeout/cancel vs. callback) ya lo cerró.
+  bool fijar(uint8_t r) {
+#if defined(ESP32)
+    uint8_t e = RUNNING;
+    return _res.compare_exchange_strong(e, r);
+#else
+    if (_res != RUNNING) return false;
+    _res = r;
+    return true;
+#endif
+  }
+
+  // ---- contexto lwIP ----
+  static void arrancarCb(void* arg) { static_cast<AwmProbe*>(arg)->arrancar(); }
+  static void cerrarCb(void* arg)   { static_cast<AwmProbe*>(arg)->terminar(IDLE); }
+
+  void arrancar() {
+    _genLwip = _gen;
+    if (_res != RUNNING) return;   // cancelada antes de entrar
+    _fase = F_DNS;
+    if (_modo == DNS) _tMarca = _t0;
+    ip_addr_t ip;
+    const err_t e = dns_gethostbyname(_host, &ip, dnsCb, this);
+    if (e == ERR_OK) { _cache = true; resuelto(&ip); }
+    else if (e != ERR_INPROGRESS) terminar(ERR_DNS);
+  }
+
+  static void dnsCb(const char* name, const ip_addr_t* ip, void* arg) {
+    AwmProbe* p = static_cast<AwmProbe*>(arg);
+    // Respuesta de una sonda ya vencida (DNS no se puede cancelar)
+    if (p->_fase != F_DNS || strcmp(name, p->_host) != 0) return;
+    if (ip) p->resuelto(ip);
+    else    p->terminar(ERR_DNS);
+  }
+
+  void resuelto(const ip_addr_t* ip) {
+    _tDns = millis();
+    switch (_modo) {
+      case DNS:  terminar(OK);     break;
+      case PING: enviarPing(ip);   break;
+      default:   conectar(ip);     break;
+    }
+  }
+
+  void conectar(const ip_addr_t* ip) {
+    _tMarca = _tDns;
+    _fase = F_TCP;
+    _pcb = tcp_new();
+    if (!_pcb) { terminar(ERR_CONNECT); return; }
+    tcp_arg(_pcb, this);
+    tcp_err(_pcb, errCb);
+    tcp_recv(_pcb, recvCb);
+    if (tcp_connect(_pcb, ip, _port, conectadoCb) != ERR_OK) terminar(ERR_CONNECT);
+  }
+
+  static err_t conectadoCb(void* arg, struct tcp_pcb* pcb, err_t /*err*/) {
+    AwmProbe* p = static_cast<AwmProbe*>(arg);
+    if (p->_modo == TCP) { p->terminar(OK); return ERR_ABRT; }
+    p->_tMarca = millis();
+    p->_fase = F_HTTP;
+    p->_nLinea = 0;
+    if (tcp_write(pcb, p->_req, p->_reqLen, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+      p->terminar(ERR_CONNECT);
+      return ERR_ABRT;
+    }
+    tcp_output(pcb);
+    return ERR_OK;
+  }
+
+  static err_t recvCb(void* arg, struct tcp_pcb* pcb, struct pbuf* pb, err_t /*err*/) {
+    AwmProbe* p = static_cast<AwmProbe*>(arg);
+    if (!pb) { p->terminar(ERR_REPLY); return ERR_ABRT; }   // cerró sin línea de estado
+    const size_t lugar = sizeof(p->_linea) - 1 - p->_nLinea;
+    if (lugar) p->_nLinea += pbuf_copy_partial(pb, p->_linea + p->_nLinea, (uint16_t)lugar, 0);
+    tcp_recved(pcb, pb->tot_len);
+    pbuf_free(pb);
+
+    // "HTTP/1.1 204 …": alcanza con los primeros 12 bytes
+    if (p->_nLinea < 12) return ERR_OK;
+    p->_linea[p->_nLinea] = '\0';
+    if (strncmp(p->_linea, "HTTP/", 5) != 0 || p->_linea[8] != ' ') {
+      p->terminar(ERR_REPLY);
+      return ERR_ABRT;
+    }
+    p->_code = (int16_t)atoi(p->_linea + 9);
+    p->terminar(OK);
+    return ERR_ABRT;
+  }
+
+  // El PCB raw se crea una vez y queda: raw_remove() desde su propio callback
+  // no es seguro (raw_input() lo sigue usando al volver).
+  void enviarPing(const ip_addr_t* ip) {
+    _tMarca = _tDns;
+    _fase = F_PING;
+    if (!_raw) {
+      _raw = raw_new(IP_PROTO_ICMP);
+      if (!_raw) { terminar(ERR_CONNECT); return; }
+      raw_recv(_raw, pingCb, this);
+      raw_bind(_raw, IP_ADDR_ANY);
+    }
+    struct pbuf* pb = pbuf_alloc(PBUF_IP, sizeof(struct icmp_echo_hdr) + PING_DATOS, PBUF_RAM);
+    if (!pb) { terminar(ERR_CONNECT); return; }
+    struct icmp_echo_hdr* h = (struct icmp_echo_hdr*)pb->payload;
+    ICMPH_TYPE_SET(h, ICMP_ECHO);
+    ICMPH_CODE_SET(h, 0);
+    h->id     = PING_ID;
+    h->seqno  = lwip_htons(++_seq);
+    memset(h + 1, 0xA5, PING_DATOS);
+    h->chksum = 0;
+    h->chksum = inet_chksum(h, pb->len);
+    const err_t e = raw_sendto(_raw, pb, ip);
+    pbuf_free(pb);
+    if (e != ERR_OK) terminar(ERR_CONNECT);
+  }
+
+  static u8_t pingCb(void* arg, struct raw_pcb* /*pcb*/, struct pbuf* pb, const ip_addr_t* /*addr*/) {
+    AwmProbe* p = static_cast<AwmProbe*>(arg);
+    if (p->_fase != F_PING) return 0;
+    uint8_t v = 0;
+    struct icmp_echo_hdr h;
+    pbuf_copy_partial(pb, &v, 1, 0);
+    const uint16_t ihl = (v & 0x0f) * 4;   // pb trae la cabecera IP
+    if (pbuf_copy_partial(pb, &h, sizeof(h), ihl) != sizeof(h)) return 0;
+    if (ICMPH_TYPE(&h) != ICMP_ER || h.id != PING_ID || h.seqno != lwip_htons(p->_seq)) return 0;
+    pbuf_free(pb);
+    p->terminar(OK);
+    return 1;   // consumido
+  }
+
+  static void errCb(void* arg, err_t /*err*/) {
+    AwmProbe* p = static_cast<AwmProbe*>(arg);
+    p->_pcb = nullptr;   // lwIP ya lo liberó
+    p->terminar(ERR_CONNECT);
+  }
+
+  void terminar(uint8_t r) {
+    if (_pcb) {
+      tcp_arg(_pcb, nullptr);
+      tcp_err(_pcb, nullptr);
+      tcp_recv(_pcb, nullptr);
+      tcp_abort(_pcb);
+      _pcb = nullptr;
+    }
+    _fase = F_NADA;
+    // Un PCB viejo puede avisar después de un start() nuevo (el cierre del
+    // timeout todavía en la cola de lwIP): su resultado no es de esta sonda.
+    if (r != IDLE && _genLwip == _gen && fijar(r)) _tFin = millis();
+  }
+
+  // Configuración: la escribe start() antes de entrar a lwIP
+  char     _host[HOST_MAX + 1];
+  char     _req[RUTA_MAX + HOST_MAX + 80];
+  uint16_t _reqLen  = 0;
+  uint16_t _port    = 80;
+  uint32_t _timeout = 0;
+  uint32_t _t0      = 0;
+  uint8_t  _modo    = HTTP;
+  volatile uint8_t _gen = 0;   // una por start(); lwIP copia la suya al arrancar
+
+  // Resultado: lo publican los callbacks
+#if defined(ESP32)
+  std::atomic<uint8_t> _res{IDLE};
+#else
+  volatile uint8_t _res = IDLE;
+#endif
+  volatile int16_t  _code  = 0;
+  volatile uint32_t _tDns = 0, _tMarca = 0, _tFin = 0;
+  volatile bool     _cache = false;
+  uint32_t _heap0 = 0, _heapMin = 0;   // solo loop (poll)
+
+  // Solo contexto lwIP
+  struct tcp_pcb* _pcb = nullptr;
+  struct raw_pcb* _raw = nullptr;
+  uint16_t _seq = 0;
+  volatile uint8_t _fase = F_NADA;
+  uint8_t _genLwip = 0;
+  char    _linea[16];
+  uint8_t _nLinea = 0;
+};
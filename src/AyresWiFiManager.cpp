@@ -51,7 +51,8 @@
  *  Novedades v2.0.1
  *  ---------------------------------------------------------------
  *  • Reconexión configurable:
- *      - setReconnectBackoffMs(ms) → retraso mínimo entre reintentos (por defecto 10 s)
+ *      - setReconnectBackoffMs(ms) → retraso mínimo entre reintentos (por defecto 10 s);
+ *        setReconnectBackoffPolicy() lo vuelve exponencial con jitter (AWM_Backoff.h)
  *      - setReconnectAttemptMs(ms) → ventana por intento (por defecto 5 s)
  *  • Convivencia con AP/portal externo:
  *      - setExternalApActive(true) habilita escenarios AP+STA sin bajar el SoftAP
@@ -61,8 +62,78 @@
  *      - forzarReconexion() y reintentarConexionSiNecesario() respetan dicho flag.
  *
  *  Consideraciones de rendimiento
+ *      - Las páginas del portal se envían por bloques (AWM_STREAM_CHUNK), sin
+ *        readString(): el HTML nunca se copia entero al heap.
+ *      - Si existe "<página>.gz" (tools/gzip_assets.py) se sirve comprimida
+ *        cuando el cliente envía Accept-Encoding: gzip.
+ *      - Con AWM_EMBED_PORTAL=1 las páginas salen de flash (tools/embed_assets.py):
+ *        sin llamadas al FS en el camino del portal.
+ *      - GET / lleva ETag (hash del contenido) + Cache-Control: al reabrir el
+ *        portal el navegador revalida y recibe 304 sin cuerpo.
  *      - Evitar escaneos demasiado frecuentes (SCAN_INTERVAL_MS).
- *      - Cachear el resultado de /scan(.json) si la ventana es corta.
+ *      - /scan(.json) se responde desde cache dentro de setScanCacheMs()
+ *        (por defecto SCAN_CACHE_MS = 10 s).
+ *      - El escaneo del portal es asíncrono: /scan nunca bloquea DNS/HTTP;
+ *        devuelve el último resultado o 202 y update() recoge el nuevo.
+ *      - /events (SSE) empuja escaneos, estado de conexión y cuenta regresiva
+ *        del portal por una sola conexión por cliente: la página no hace polling.
+ *      - POST /save no reinicia: prueba las credenciales en AP+STA desde
+ *        update(), informa el progreso (SSE "link" o GET /status) y solo si el
+ *        STA obtiene IP las guarda y cierra el portal. Sin reboot, remontaje
+ *        del FS ni ventana del botón: el time-to-online queda en el log y en
+ *        getLastProvisionMs(); examples/AWM_ProvisionCost lo compara con el
+ *        camino de reinicio.
+ *      - run() no bloquea: la conexión (beginConnect) y la ventana del botón
+ *        avanzan desde update(); connectToWiFi() queda como wrapper bloqueante.
+ *      - Reconexión: update() llama a reintentarConexionSiNecesario() tras
+ *        una caída (setAutoReconnect(true), por defecto); arma el intento y
+ *        update() lo ejecuta por pasos sin superar setReconnectBudgetMs() por vuelta,
+ *        así HTTP/DNS del portal en AP+STA no se congelan durante el reintento.
+ *      - /wifi.json guarda BSSID y canal del último AP: los intentos siguientes
+ *        van directo a ese AP (sin barrer canales) y solo si no asocia en
+ *        PISTA_VENTANA_MS se repite con barrido completo.
+ *      - /wifi.json guarda hasta AWM_MAX_NETWORKS redes. Con más de una, un
+ *        escaneo (solo si la última red no asocia por su pista) deja probar
+ *        únicamente las presentes, por RSSI/prioridad/historial, con ventana
+ *        adaptativa por red (2.5× su última asociación): un equipo movido de
+ *        sitio no agota ventanas contra SSIDs que no están.
+ *      - /wifi.json guarda la PSK (PMK en 64 hex, AWM_Pmk.h) y no la passphrase:
+ *        WiFi.begin() se saltea PBKDF2-SHA1 (4096 iteraciones) en cada
+ *        conexión. La derivación se hace una vez (en /save, por tramos) y los
+ *        archivos viejos con "password" se migran al cargarlos.
+ *      - setLeaseCache(true): el último lease DHCP (/lease.json) se aplica como
+ *        IP estática en la próxima conexión; un ARP al gateway (sin bloquear)
+ *        lo confirma, otro a la propia IP descarta una duplicada, y si algo
+ *        falla se vuelve a DHCP. Sin hora válida al arrancar la edad del lease
+ *        no se puede verificar y no se usa. getLastConnectMs() da
+ *        inicio→IP usable; examples/AWM_LeaseCost compara DHCP y lease en la placa.
+ *      - El estado del enlace STA lo mantienen los eventos Wi-Fi del core
+ *        (WiFi.onEvent / onStationMode*): isConnected(), el LED, los
+ *        reintentos y connectTask() leen una variable en vez de llamar a
+ *        WiFi.status() en cada vuelta; un sondeo a 1 Hz cubre eventos perdidos.
+ *      - El reason de STA_DISCONNECTED elige la estrategia: clave rechazada
+ *        reintenta cada 5 min (el portal, según la política), AP ausente
+ *        espera cada vez más, beacon perdido reintenta ya. Dentro de un intento, AUTH y NO_AP
+ *        cortan la ventana sin esperarla. getRecoveryStats() da el tiempo de
+ *        recuperación por clase.
+ *      - SNTP no bloquea: run() y las reconexiones solo llaman configTime();
+ *        el aviso del core llega a onTimeSync() desde update(). La hora se
+ *        copia a memoria RTC cada segundo (AWM_RTC_TIME) y tras un reinicio
+ *        en caliente getTimestamp() es usable antes de que responda SNTP.
+ *      - hayInternet() ya no hace un GET bloqueante (hasta 3 s por llamada):
+ *        devuelve el veredicto cacheado (setInternetCheck) y, vencido, update()
+ *        lanza una sonda por la API raw de lwIP (AWM_Probe.h) sobre varios
+ *        destinos. Sin HTTPClient: la sonda corta al leer la línea de estado.
+ *        Modos más baratos por destino: tcp:// (solo handshake), dns:// (solo
+ *        resolución) y ping:// (echo ICMP, p. ej. al gateway); su costo frente
+ *        al GET de antes lo mide examples/AWM_ProbeCost. Un ping o un DNS
+ *        respondido por el cache de lwIP no confirman Internet.
+ *      - getInternetState() separa sin DNS / sin salida / portal cautivo
+ *        aguas arriba (200/302 en vez de 204): la app deja de empujar datos
+ *        a un walled garden. Estadísticas de rtt por destino, sin sondas extra.
+ *      - Monitor de salud (AWM_Health.h): una muestra cada 5 s en un anillo
+ *        fijo, sin heap; WiFi.RSSI() solo se lee ahí. getLinkQuality() es un
+ *        valor ya calculado (O(1)): consultarlo en cada vuelta no cuesta nada.
  *      - Ajustar patrones del LED para minimizar jitter en WiFi/HTTP.
  */
 
@@ -70,25 +141,50 @@
 #include "AyresWiFiManager.h"
 #include <ArduinoJson.h>
 #include "AWM_Logging.h"
+#include "AWM_JsonWriter.h"
+#include "AWM_Probe.h"
 
 #if defined(ESP32)
-  #include <HTTPClient.h>
   #include <esp_wifi.h>
-#elif defined(ESP8266)
-  #include <ESP8266HTTPClient.h>
 #endif
 
 #include <time.h>
+#include <sys/time.h>
+#include <algorithm>
+#if defined(ESP32)
+  #include <esp_sntp.h>
+  #include <esp_attr.h>
+  #include <esp_idf_version.h>
+#else
+  #include <coredecls.h>   // settimeofday_cb
+#endif
+#include <lwip/etharp.h>
+#include <lwip/netif.h>
+#include <lwip/pbuf.h>
+#if defined(ESP32)
+  #include <lwip/tcpip.h>
+  #include <lwip/sockets.h>   // send(MSG_DONTWAIT) a los suscriptores SSE
+#endif
+
+#if AWM_EMBED_PORTAL
+  #include <AWM_PortalAssets.h>   // generado por tools/embed_assets.py
+  static_assert(sizeof(AWM_PORTAL_ASSETS) / sizeof(AWM_PORTAL_ASSETS[0]) == 3,
+                "AWM_PortalAssets.h desactualizado: regenerar con tools/embed_assets.py");
+#endif
 
 // ---------- ctor ----------
 AyresWiFiManager::AyresWiFiManager(uint8_t ledPin_, uint8_t buttonPin_)
-: server(80), ledPin(ledPin_), buttonPin(buttonPin_) {}
+: server(80),
+  netSondas{ { "clients3.google.com",           "/generate_204", 80, 204, AwmProbe::HTTP, {} },
+             { "connectivitycheck.gstatic.com", "/generate_204", 80, 204, AwmProbe::HTTP, {} } },
+  ledPin(ledPin_), buttonPin(buttonPin_) {}
 
 // =====================================================
 //                 SETTERS / TOGGLES
 // =====================================================
 void AyresWiFiManager::setHtmlPathPrefix(const String& prefix) {
   htmlPathPrefix = prefix.endsWith("/") ? prefix : prefix + "/";
+  assets.clear();
 }
 
 void AyresWiFiManager::setHostname(const String& host){ hostname = host; }
@@ -113,13 +209,33 @@ void AyresWiFiManager::enableButtonPortal(bool enable){ allowButtonPortal = enab
 
 // ===== [NEW] Reconexión configurable =====
 void AyresWiFiManager::setReconnectBackoffMs(uint32_t ms){
-  reconnectBackoffMs = (ms < 1000) ? 1000 : ms; // sanity min 1s
-  AWM_LOGI("⚙️  Backoff de reconexión = %lu ms", (unsigned long)reconnectBackoffMs);
+  setReconnectBackoffPolicy(ms, backoffMult, backoffCapMs, backoffJitterPct);
+}
+void AyresWiFiManager::setReconnectBackoffPolicy(uint32_t baseMs, float multiplier,
+                                                 uint32_t capMs, uint8_t jitterPct){
+  reconnectBackoffMs = (baseMs < 1000) ? 1000 : baseMs; // sanity min 1s
+  backoffMult        = multiplier;
+  backoffCapMs       = capMs;
+  backoffJitterPct   = jitterPct;
+  backoff.config(reconnectBackoffMs, backoffMult, backoffCapMs, backoffJitterPct);
+  esperaReintentoMs  = reconnectBackoffMs;
+  AWM_LOGI("⚙️  Backoff de reconexión = %lu ms ×%.2f hasta %lu ms, jitter %u%%",
+           (unsigned long)reconnectBackoffMs, (double)backoffMult,
+           (unsigned long)backoff.capMs(), backoffJitterPct);
 }
 void AyresWiFiManager::setReconnectAttemptMs(uint32_t ms){
   reconnectAttemptMs = (ms < 1000) ? 1000 : ms; // min 1s
   AWM_LOGI("⚙️  Ventana de intento = %lu ms", (unsigned long)reconnectAttemptMs);
 }
+void AyresWiFiManager::setLeaseCache(bool enabled, uint32_t maxAgeS){
+  leaseOn      = enabled;
+  leaseMaxAgeS = maxAgeS;
+  AWM_LOGI("⚙️  Lease DHCP cacheado: %s (vence %lu s)", enabled ? "sí" : "no", (unsigned long)maxAgeS);
+}
+void AyresWiFiManager::setReconnectBudgetMs(uint32_t ms){
+  reconnectBudgetMs = ms;
+  AWM_LOGI("⚙️  Presupuesto por update() = %lu ms", (unsigned long)reconnectBudgetMs);
+}
 // ===== [NEW] AP/portal externo =====
 void AyresWiFiManager::setExternalApActive(bool active){
   externalApActive = active;
@@ -127,6 +243,10 @@ void AyresWiFiManager::setExternalApActive(bool active){
 }
 bool AyresWiFiManager::isExternalApActive() const { return externalApActive; }
 
+void AyresWiFiManager::setScanCacheMs(uint32_t ms){ scanCacheMs = ms; }
+AyresWiFiManager::ScanStats AyresWiFiManager::getScanStats() const { return scanStats; }
+uint32_t AyresWiFiManager::getLastProvisionMs() const { return lastProvisionMs; }
+
 // =====================================================
 //                      BEGIN / RUN
 // =====================================================
@@ -135,16 +255,26 @@ void AyresWiFiManager::begin() {
   digitalWrite(ledPin, LOW);
   pinMode(buttonPin, INPUT_PULLUP);
 
+  // Los reintentos los arma update() con backoff (setAutoReconnect); el del
+  // driver reasociaría por su cuenta, sin espera ni jitter
 #if defined(ESP32)
   WiFi.persistent(false);
-  WiFi.setAutoReconnect(true);
+  WiFi.setAutoReconnect(false);
   WiFi.setSleep(false);
   esp_wifi_set_ps(WIFI_PS_NONE);
 #else
   WiFi.persistent(false);
-  WiFi.setAutoReconnect(true);
+  WiFi.setAutoReconnect(false);
   WiFi.setSleepMode(WIFI_NONE_SLEEP);
 #endif
+  registrarEventosWiFi();
+  restaurarHoraRtc();
+
+  // Semilla del jitter de reintentos: distinta por equipo, estable entre reinicios
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  backoff.config(reconnectBackoffMs, backoffMult, backoffCapMs, backoffJitterPct);
+  backoff.seed(mac);
 
 #if defined(ESP32)
   if (!LittleFS.begin(true)) {
@@ -158,57 +288,23 @@ void AyresWiFiManager::begin() {
   loadCredentials();
 }
 
+// No bloquea: abre la ventana de 2 s del botón (la atiende botonTask) y lanza
+// la conexión en paralelo. El resultado (NTP o política de fallback) lo aplica
+// update() al terminar el intento.
 void AyresWiFiManager::run() {
-  // Ventana para detectar hold con feedback LED
   AWM_LOGI("🔔 Botón: 2–5s abre portal | ≥5s borra credenciales");
-
-  unsigned long startTime = millis();
-  bool pressed = false;
-
-  ledSet(LedPattern::BLINK_SLOW); // guiño durante ventana
-  while (millis() - startTime < 2000) {
-    if (digitalRead(buttonPin) == LOW) { pressed = true; break; }
-    ledTask(); delay(10);
-  }
-  ledSet(LedPattern::OFF);
-
-  if (pressed) {
-    unsigned long t0 = millis();
-    while (digitalRead(buttonPin) == LOW) {
-      unsigned long held = millis() - t0;
-      if (held >= 5000) {
-        setLedPatternManual(LedPattern::BLINK_TRIPLE);
-        AWM_LOGW("🩹 Hold ≥5s → borrar credenciales y reiniciar");
-        eraseCredentials();
-        delay(900);
-        ESP.restart();
-      } else if (held >= 2000) {
-        setLedPatternManual(LedPattern::BLINK_DOUBLE); // avisar: abriré portal
-      } else {
-        setLedPatternManual(LedPattern::BLINK_FAST);   // hold corto
-      }
-      ledTask(); delay(10);
-    }
-    unsigned long held = millis() - t0;
-    if (held >= 2000 && held < 5000 && allowButtonPortal) {
-      AWM_LOGI("🟢 Hold 2–5s → abrir portal");
-      setLedAuto(true);
-      startPortal();
-      return;
-    }
-    setLedAuto(true);
-  }
+  btnFase = BTN_VENTANA;
+  btnT0   = millis();
+  setLedPatternManual(LedPattern::BLINK_SLOW); // guiño durante ventana
 
   // Conectar si hay credenciales
-  if (connectToWiFi()) {
-    AWM_LOGI("✅ Conexión WiFi exitosa.");
-    sincronizarHoraNTP();
-    ledSet(LedPattern::ON);
-    connected = true;
-    return;
+  if (!tieneCredenciales() || !iniciarConexion(CONN_RUN, CONNECT_TIMEOUT_MS)) {
+    aplicarFallback();
   }
+}
 
-  // No conectó → actuar según política
+// No conectó (o no hay credenciales) → actuar según política
+void AyresWiFiManager::aplicarFallback() {
   switch (fallbackPolicy) {
     case FallbackPolicy::ON_FAIL:
       AWM_LOGI("🟡 Conexión fallida → abriendo portal (policy=ON_FAIL)");
@@ -234,11 +330,74 @@ void AyresWiFiManager::run() {
   }
 }
 
+// Llamado desde update(): ventana de arranque y hold del botón.
+//   hold 2–5 s → abre portal (cancela la conexión de run())
+//   hold ≥5 s  → borra credenciales y reinicia
+void AyresWiFiManager::botonTask() {
+  if (btnFase == BTN_INACTIVO) return;
+  const unsigned long now = millis();
+  const bool pressed = (digitalRead(buttonPin) == LOW);
+
+  if (btnFase == BTN_VENTANA) {
+    if (pressed) {
+      btnFase = BTN_PRESIONADO;
+      btnT0   = now;
+      setLedPatternManual(LedPattern::BLINK_FAST);   // hold corto
+    } else if (now - btnT0 >= BOOT_WINDOW_MS) {
+      btnFase = BTN_INACTIVO;
+      setLedAuto(true);
+    }
+    return;
+  }
+
+  const unsigned long held = now - btnT0;
+  if (pressed) {
+    if (held >= 5000) {
+      setLedPatternManual(LedPattern::BLINK_TRIPLE);
+      AWM_LOGW("🩹 Hold ≥5s → borrar credenciales y reiniciar");
+      eraseCredentials();
+      delay(900);
+      ESP.restart();
+    } else if (held >= 2000 && ledPat != LedPattern::BLINK_DOUBLE) {
+      setLedPatternManual(LedPattern::BLINK_DOUBLE); // avisar: abriré portal
+    }
+    return;
+  }
+
+  // Soltado
+  btnFase = BTN_INACTIVO;
+  setLedAuto(true);
+  if (held >= 2000 && allowButtonPortal) {
+    AWM_LOGI("🟢 Hold 2–5s → abrir portal");
+    if (connOrigen == CONN_RUN && connState == ConnectState::CONNECTING) {
+      connState = ConnectState::IDLE;   // el portal reemplaza al intento de arranque
+    }
+    startPortal();
+  }
+}
+
 // =====================================================
 void AyresWiFiManager::update() {
   server.handleClient();
   if (dnsRunning) dns.processNextRequest();
 
+  linkTask();
+  botonTask();
+  connectTask();
+  // Reconexión con backoff tras una caída o un intento fallido: no hace falta
+  // que el sketch llame a reintentarConexionSiNecesario(). IDLE = run() aún
+  // no arrancó (o el portal reemplazó al intento de arranque).
+  if (autoReconnect && !portalActive && !connected && connState != ConnectState::IDLE) {
+    reintentarConexionSiNecesario();
+  }
+  leaseTask();
+  ntpTask();
+  internetTask();
+  saludTask();
+  escaneoTask();
+  provisionTask();
+  sseTask();
+
   ledAutoUpdate();
   ledTask();
 
@@ -260,14 +419,22 @@ void AyresWiFiManager::redirectToRoot(){
 }
 
 void AyresWiFiManager::setupHTTPRoutes(){
+  // Cabeceras de request que necesitamos leer (el WebServer descarta el resto)
+  static const char* kHeaders[] = { "Accept-Encoding", "If-None-Match" };
+  server.collectHeaders(kHeaders, sizeof(kHeaders) / sizeof(kHeaders[0]));
+
   // Páginas propias
   server.on("/",      std::bind(&AyresWiFiManager::handleRoot, this));
   server.on("/save",  std::bind(&AyresWiFiManager::handleSave, this));
+  server.on("/status", HTTP_GET, std::bind(&AyresWiFiManager::handleStatus, this));
 
   // Escaneo: principal y alias clásico
   server.on("/scan",      std::bind(&AyresWiFiManager::handleScan, this));
   server.on("/scan.json", std::bind(&AyresWiFiManager::handleScan, this));
 
+  // Push de escaneo/estado (Server-Sent Events)
+  server.on("/events", HTTP_GET, std::bind(&AyresWiFiManager::handleEvents, this));
+
   // NUEVO: borrar credenciales vía POST /erase
   server.on("/erase", HTTP_POST, std::bind(&AyresWiFiManager::handleErase, this));
 
@@ -322,12 +489,13 @@ void AyresWiFiManager::startPortal(){
   portalActive    = true;
   portalStart     = millis();
   lastHttpAccess  = portalStart;
-  AWM_LOGI("🌐 Portal cautivo activo en 192.168.4.1 (GET /, /scan, POST /save, POST /erase)");
+  AWM_LOGI("🌐 Portal cautivo activo en 192.168.4.1 (GET /, /scan, /status, POST /save, POST /erase)");
   ledSet(LedPattern::BLINK_SLOW);
 }
 
 void AyresWiFiManager::stopPortal(){
   if (!portalActive) return;
+  sseCerrarTodos();
   stopDNS();
   server.stop();
 
@@ -339,6 +507,13 @@ void AyresWiFiManager::stopPortal(){
   }
 
   portalActive = false;
+  std::vector<ScanEntry>().swap(scanResults);   // liberar el cache de /scan
+  scanHasResult = false;
+
+  // Una prueba de /save sin terminar se abandona (nada quedó guardado)
+  if (provEstado == PROV_PROBANDO) WiFi.disconnect();
+  provEstado = PROV_IDLE;
+  provPass   = String();
 
   // [CHANGED] Restaurar modo según contexto:
   if (externalApActive) {
@@ -389,20 +564,24 @@ void AyresWiFiManager::handleRoot() {
   if (captivePortalRedirect()) return;
   lastHttpAccess = millis();
 
-  String path = htmlPathPrefix + "index.html";
-  if (!LittleFS.exists(path)) {
+  if (!enviarPagina(PAG_INDEX)) {
     server.send(500, "text/html", "<h1>Error: index.html no encontrado</h1>");
-    return;
-  }
-  File file = LittleFS.open(path, "r");
-  if (!file || file.isDirectory()) {
-    server.send(500, "text/html", "<h1>Error abriendo index.html</h1>");
-    return;
   }
-  server.send(200, "text/html", file.readString());
-  file.close();
 }
 
+// Solo una passphrase WPA (8..63 caracteres) se cambia por su PMK. El resto
+// (claves WEP de 5/13, lo que el driver quiera recibir tal cual) se guarda y
+// se pasa a begin() sin tocar.
+static bool esPassphraseWpa(const char* pass) {
+  const size_t n = strlen(pass);
+  return n >= 8 && n <= 63;
+}
+
+// POST /save: no guarda ni reinicia. Lanza una prueba de las credenciales en
+// AP+STA (el portal sigue arriba) y responde al instante; provisionTask() la
+// sigue desde update() y solo persiste si el STA obtiene IP.
+//   ?async=1 (fetch de la página) → 202 + JSON de estado (igual que /status)
+//   formulario clásico            → success.html ("probando conexión")
 void AyresWiFiManager::handleSave() {
   if (captivePortalRedirect()) return;
   lastHttpAccess = millis();
@@ -412,35 +591,173 @@ void AyresWiFiManager::handleSave() {
     return;
   }
 
+  const bool async = server.hasArg("async");
   String inSsid = server.arg("ssid");
   String inPass = server.arg("password");
   if (inSsid.isEmpty() || inPass.isEmpty()) {
-    mostrarPaginaError("Faltan datos para guardar.");
+    if (async) server.send(400, "application/json", "{\"state\":\"failed\",\"reason\":\"missing\"}");
+    else       mostrarPaginaError("Faltan datos para guardar.");
     return;
   }
+  // Passphrase WPA (8..63) → PMK por tramos; PSK de 64 hex o cualquier otra
+  // clave (WEP) se prueba y se guarda tal cual
+  const bool pskHex = AwmPmk::esHex(inPass.c_str());
+
+  provSsid     = inSsid;
+  provPass     = inPass;
+  provDerivando = !pskHex && esPassphraseWpa(inPass.c_str());
+  if (provDerivando) provPmk.begin(inPass.c_str(), inSsid.c_str());
+  provEstado   = PROV_PROBANDO;
+  provMotivo   = nullptr;
+  provIniciado = false;
+  provStart    = millis();
+  if (connState == ConnectState::CONNECTING) {   // la prueba reemplaza al intento en curso
+    connState = ConnectState::IDLE;
+  }
+  AWM_LOGI("🧪 Probando credenciales de \"%s\" (AP+STA, sin reinicio)", provSsid.c_str());
+  provisionTask();   // WiFi.begin() ya mismo si no hay un escaneo en curso
 
-  StaticJsonDocument<192> doc;
-  doc["ssid"]     = inSsid;
-  doc["password"] = inPass;
+  if (async) {
+    enviarEstadoProvision(202);
+  } else if (!enviarPagina(PAG_SUCCESS)) {
+    server.send(200, "text/html", "<h1>Probando conexión...</h1>");
+  }
+  sseEstadoProvision();
+}
 
-  File file = LittleFS.open("/wifi.json", "w");
-  if (!file) {
-    mostrarPaginaError("Error al guardar credenciales.");
+// GET /status: estado de la última provisión (fallback sin EventSource).
+void AyresWiFiManager::handleStatus() {
+  if (captivePortalRedirect()) return;
+  lastHttpAccess = millis();
+  enviarEstadoProvision(200);
+}
+
+void AyresWiFiManager::enviarEstadoProvision(int code) {
+  server.sendHeader("Cache-Control", "no-store");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(code, "application/json", "");
+
+  AwmJsonWriter w([](void* ctx, const char* data, size_t len){
+    static_cast<WebServer*>(ctx)->sendContent(data, len);
+  }, &server);
+  escribirEstadoProvision(w);
+  w.flush();
+  server.sendContent("");   // fin del chunked
+}
+
+// {"state":"idle|connecting|connected|failed","ssid":..,"ip":..,"elapsed_ms":..,"reason":..}
+void AyresWiFiManager::escribirEstadoProvision(AwmJsonWriter& w) const {
+  static const char* const kEstados[] = { "idle", "connecting", "connected", "failed" };
+  w.raw("{\"state\":"); w.str(kEstados[provEstado]);
+  if (provEstado == PROV_IDLE) { w.raw('}'); return; }
+
+  w.raw(",\"ssid\":"); w.str(provSsid.c_str());
+  if (provEstado == PROV_OK) {
+    w.raw(",\"ip\":"); w.str(WiFi.localIP().toString().c_str());
+  }
+  const unsigned long fin = (provEstado == PROV_PROBANDO) ? millis() : provFinAt;
+  w.raw(",\"elapsed_ms\":"); w.num((long)(fin - provStart));
+  if (provMotivo) { w.raw(",\"reason\":"); w.str(provMotivo); }
+  w.raw('}');
+}
+
+// Llamado desde update(): avanza la prueba de credenciales lanzada por /save.
+// Nota ESP8266/ESP32: en AP+STA el AP se muda al canal del router al asociar;
+// el teléfono suele seguirlo, y si no, la página vuelve por SSE/polling.
+void AyresWiFiManager::provisionTask() {
+  const unsigned long now = millis();
+
+  if (provEstado == PROV_OK) {
+    // Cerrar el portal cuando la página ya tuvo tiempo de mostrar la IP
+    if (portalActive && now - provFinAt >= PROV_CLOSE_MS) {
+      stopPortal();
+      sincronizarHoraNTP();
+    }
     return;
   }
-  serializeJson(doc, file);
-  file.close();
+  if (provEstado != PROV_PROBANDO) return;
+
+  if (provDerivando) {
+    // PMK por tramos (reconnectBudgetMs por vuelta): la passphrase no llega al
+    // driver ni a flash; begin() recibe directamente la PSK
+    const unsigned long t0 = millis();
+    while (!provPmk.step(64) && millis() - t0 < reconnectBudgetMs) {}
+    if (!provPmk.done()) return;
+    char psk[65];
+    provPmk.hex(psk);
+    provPass      = psk;
+    provDerivando = false;
+    AWM_LOGD("🔑 PMK derivada en %lu ms", (unsigned long)(millis() - provStart));
+  }
 
-  File success = LittleFS.open(htmlPathPrefix + "success.html", "r");
-  if (!success) {
-    server.send(200, "text/html", "<h1>Guardado. Reiniciando...</h1>");
+  if (!provIniciado) {
+    if (scanning) return;   // el STA no asocia mientras escanea: esperar
+    if (WiFi.getMode() != WIFI_AP_STA) WiFi.mode(WIFI_AP_STA);
+    if (leaseAplicado) {    // red nueva: DHCP, no la IP estática del lease anterior
+      WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+      leaseAplicado = false;
+    }
+    // begin() reinicia la asociación: no confundir el enlace anterior con este
+    linkEstado   = LinkState::DOWN;
+    linkMotivo   = 0;
+    linkSondeoAt = now;
+    WiFi.begin(provSsid.c_str(), provPass.c_str());
+    provIniciado = true;
+    provBeginAt  = now;
+    return;
+  }
+
+  // Éxito: GOT_IP posterior a este begin() (el STA pudo seguir asociado a la
+  // red anterior), o WiFi.status() pasado el margen si el evento no llegó; en
+  // ambos casos asociado a la red que se está probando.
+  const wl_status_t st = WiFi.status();
+  const unsigned long used = now - provBeginAt;
+  const bool conIp = (linkEstado == LinkState::GOT_IP) ||
+                     (used >= PROV_GRACE_MS && st == WL_CONNECTED);
+  if (conIp && WiFi.SSID() == provSsid) {
+    finalizarProvision(PROV_OK, nullptr);
+    return;
+  }
+
+  // Fallos explícitos del driver (tras un margen: el estado previo del STA
+  // puede seguir reportándose justo después de begin())
+  if (used >= PROV_GRACE_MS) {
+#if defined(ESP8266)
+    if (st == WL_WRONG_PASSWORD) { finalizarProvision(PROV_FALLO, "auth"); return; }
+#endif
+    if (st == WL_CONNECT_FAILED) { finalizarProvision(PROV_FALLO, "auth");    return; }
+    if (st == WL_NO_SSID_AVAIL)  { finalizarProvision(PROV_FALLO, "no_ssid"); return; }
+  }
+  if (used >= PROV_TIMEOUT_MS) finalizarProvision(PROV_FALLO, "timeout");
+}
+
+void AyresWiFiManager::finalizarProvision(ProvEstado fin, const char* motivo) {
+  provEstado = fin;
+  provMotivo = motivo;
+  provFinAt  = millis();
+
+  if (fin == PROV_OK) {
+    lastProvisionMs = provFinAt - provStart;
+    seleccionarRed(agregarRed(provSsid, provPass));   // se suma a la lista (o la actualiza)
+    if (!recordarRed(provFinAt - provBeginAt)) saveCredentials();
+    capturarLease();
+    connected = true;
+    connState = ConnectState::CONNECTED;
+    failCount = 0; failWindowStart = 0;
+#if defined(ESP32)
+    WiFi.setSleep(false);
+#endif
+    AWM_LOGI("✅ Provisión OK: \"%s\" IP %s en %lu ms (sin reinicio)",
+             ssid.c_str(), WiFi.localIP().toString().c_str(), (unsigned long)lastProvisionMs);
   } else {
-    server.send(200, "text/html", success.readString());
-    success.close();
+    AWM_LOGW("❌ Provisión fallida (%s) en %lu ms: credenciales NO guardadas",
+             motivo, (unsigned long)(provFinAt - provStart));
+    WiFi.disconnect();   // soltar el STA; el AP del portal sigue arriba
+    provPass = String();
   }
 
-  delay(1000);
-  ESP.restart();
+  sseLastLink = (fin == PROV_OK);   // sseTask no repite el cambio de enlace
+  sseEstadoProvision();
 }
 
 void AyresWiFiManager::handleErase() {
@@ -463,55 +780,357 @@ void AyresWiFiManager::handleErase() {
   ESP.restart();
 }
 
+// /scan nunca bloquea: responde el último resultado completo (cache) o 202
+// mientras el escaneo asíncrono corre; update() recoge el resultado.
+//   200 + JSON                      → resultado fresco (dentro del TTL)
+//   200 + JSON + X-Scan-Pending: 1  → resultado anterior, hay uno nuevo en curso
+//   202 {"scanning":true,...}       → primer escaneo en curso, reintentar en retry_ms
+// Single-flight: con un escaneo en curso ningún request lanza otro; todos se
+// unen a él y, al terminar, reciben el mismo resultado (TTL ≥ SCAN_JOIN_MS).
 void AyresWiFiManager::handleScan() {
   lastHttpAccess = millis();
-  AWM_LOGI("🔍 Escaneando redes WiFi (SYNC, AP+STA)…");
+  scanStats.requests++;
+
+  // Cache: varios clientes / auto-rescan dentro del TTL no vuelven a escanear
+  const unsigned long ttl = (scanCacheMs > SCAN_JOIN_MS) ? scanCacheMs : SCAN_JOIN_MS;
+  if (scanHasResult && (millis() - lastScanAt) < ttl) {
+    scanStats.fromCache++;
+    enviarResultadoEscaneo(false);
+    AWM_LOGD("🔍 /scan desde cache (%lu ms)", (unsigned long)(millis() - lastScanAt));
+    return;
+  }
+
+  if (scanning) scanStats.joined++;
+  const bool enCurso = iniciarEscaneo();
+
+  if (scanHasResult) {
+    enviarResultadoEscaneo(enCurso);
+    return;
+  }
+  if (!enCurso) {
+    server.send(200, "application/json", "[]");
+    return;
+  }
+  server.sendHeader("Retry-After", String((SCAN_RETRY_MS + 999) / 1000));
+  server.send(202, "application/json",
+              "{\"scanning\":true,\"retry_ms\":" + String(SCAN_RETRY_MS) + "}");
+}
+
+// Escribe [{ssid, rssi, channel, bssids, secure}, ...] (ya deduplicado y
+// ordenado por señal) directo al cliente (chunked) con AwmJsonWriter: ni
+// DynamicJsonDocument ni String intermedio por request.
+// Query opcional: ?limit=N (top-N) y ?min_rssi=-80 (descarta más débiles;
+// se ignora si no es un dBm negativo).
+void AyresWiFiManager::enviarResultadoEscaneo(bool pendiente) {
+  size_t limit   = scanResults.size();
+  int    minRssi = -128;
+  if (server.hasArg("limit")) {
+    long l = server.arg("limit").toInt();
+    if (l > 0 && (size_t)l < limit) limit = (size_t)l;
+  }
+  if (server.hasArg("min_rssi")) {
+    // Solo un entero negativo (dBm): toInt() da 0 para "abc" o "" y eso
+    // filtraría todas las redes.
+    const String a = server.arg("min_rssi");
+    char* fin = nullptr;
+    const long v = strtol(a.c_str(), &fin, 10);
+    if (a.length() && fin && *fin == '\0' && v < 0 && v >= -128) minRssi = (int)v;
+  }
+
+  if (pendiente) server.sendHeader("X-Scan-Pending", "1");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+
+  AwmJsonWriter w([](void* ctx, const char* data, size_t len){
+    static_cast<WebServer*>(ctx)->sendContent(data, len);
+  }, &server);
+  escribirEscaneoJson(w, limit, minRssi);
+  w.flush();
+  server.sendContent("");   // fin del chunked
+}
+
+// Cuerpo JSON del escaneo (compartido por /scan y el evento SSE "scan").
+void AyresWiFiManager::escribirEscaneoJson(AwmJsonWriter& w, size_t limit, int minRssi) const {
+  w.raw('[');
+  size_t sent = 0;
+  for (const ScanEntry& e : scanResults) {
+    if (sent >= limit || e.rssi < minRssi) break;   // ordenado: el resto es más débil
+    if (sent++) w.raw(',');
+    w.raw("{\"ssid\":");     w.str(e.ssid);
+    w.raw(",\"rssi\":");     w.num(e.rssi);
+    w.raw(",\"channel\":");  w.num(e.channel);
+    w.raw(",\"bssids\":");   w.num(e.bssids);
+    w.raw(",\"secure\":");   w.boolean(e.secure);
+    w.raw('}');
+  }
+  w.raw(']');
+}
+
+// Lanza un escaneo asíncrono (AP+STA si hay portal o AP externo, para no
+// tumbarlo). Si ya hay uno en curso no hace nada. Devuelve true si hay un
+// escaneo corriendo.
+bool AyresWiFiManager::iniciarEscaneo() {
+  if (scanning) return true;
+  if (provEstado == PROV_PROBANDO) return false;   // no escanear mientras el STA asocia
 
   // Mantener el AP mientras el STA escanea
-  WiFi.mode(WIFI_AP_STA);
-  delay(50);
+  const bool ap = portalActive || externalApActive;
+  if (WiFi.getMode() != (ap ? WIFI_AP_STA : WIFI_STA)) {
+    WiFi.mode(ap ? WIFI_AP_STA : WIFI_STA);
+    delay(50);   // solo al cambiar de modo: el driver rechaza el scan inmediato
+  }
 
-  // Si había un scan en curso, cancelalo
-  int st = WiFi.scanComplete();
-  if (st == WIFI_SCAN_RUNNING) {
-    WiFi.scanDelete();
+  // Nunca cancelar un escaneo ajeno en curso (scanDelete): unirse a él
+  if (WiFi.scanComplete() == WIFI_SCAN_RUNNING) {
+    scanning      = true;
+    scanStartedAt = millis();
+    return true;
   }
 
-  // Estado LED de "scanning"
-  scanning = true;
-  scanningUntil = millis() + 1500;
+  int r = WiFi.scanNetworks(/*async=*/true, /*show_hidden=*/false);
+  if (r == WIFI_SCAN_FAILED) {
+    AWM_LOGW("⚠️ No se pudo iniciar el escaneo");
+    return false;
+  }
+  scanning      = true;
+  scanStartedAt = millis();
+  scanStats.scans++;
+  AWM_LOGI("🔍 Escaneando redes WiFi (ASYNC, %s)…", ap ? "AP+STA" : "STA");
+  return true;
+}
 
-  // Escaneo bloqueante (fiable y simple)
-  int n = WiFi.scanNetworks(/*async=*/false, /*show_hidden=*/false);
-  if (n < 0) {
-    scanning = false;
-    server.send(200, "application/json", "[]");
-    AWM_LOGW("⚠️ Escaneo falló, devolviendo []");
+// Llamado desde update(): recoge el resultado del escaneo asíncrono cuando
+// está listo y lo copia a scanResults (tabla acotada a AWM_SCAN_MAX_RESULTS).
+void AyresWiFiManager::escaneoTask() {
+  if (!scanning) return;
+
+  int n = WiFi.scanComplete();
+  if (n == WIFI_SCAN_RUNNING) {
+    if (millis() - scanStartedAt > SCAN_TIMEOUT_MS) {
+      AWM_LOGW("⚠️ Escaneo sin respuesta, se descarta");
+      WiFi.scanDelete();
+      scanning = false;
+    }
     return;
   }
+  scanning = false;
 
-  // Construir JSON [{ssid, rssi, secure}, ...]
-  size_t cap = 64U + (size_t)n * 64U;
-  if (cap < 512U) cap = 512U;
-  DynamicJsonDocument doc(cap);
-  JsonArray arr = doc.to<JsonArray>();
+  if (n < 0) {
+    AWM_LOGW("⚠️ Escaneo falló");
+    return;
+  }
+  const bool paraConexion = connState == ConnectState::CONNECTING && connFase == FASE_ESCANEO;
+  if (!portalActive && !paraConexion) {   // el portal se cerró mientras escaneaba
+    WiFi.scanDelete();
+    return;
+  }
 
+  // Copiar a la tabla compacta: el próximo scanNetworks() borra la lista del
+  // driver y /scan debe poder seguir sirviendo este resultado mientras tanto.
+  // Una entrada por SSID (el BSSID más fuerte manda rssi/canal/seguridad);
+  // si la tabla se llena, una red nueva solo entra desplazando a la más débil.
+  scanResults.clear();
+  scanResults.reserve(n < AWM_SCAN_MAX_RESULTS ? n : AWM_SCAN_MAX_RESULTS);
   for (int i = 0; i < n; ++i) {
     String s = WiFi.SSID(i);
     if (!s.length()) continue; // ocultos
-    JsonObject o = arr.createNestedObject();
-    o["ssid"]   = s;
-    o["rssi"]   = WiFi.RSSI(i);
-    o["secure"] = (WiFi.encryptionType(i) != WIFI_AUTH_OPEN);
+
+    const int8_t rssi = (int8_t)WiFi.RSSI(i);
+    ScanEntry* dst = nullptr;
+    for (auto& e : scanResults) {
+      if (strcmp(e.ssid, s.c_str()) == 0) { dst = &e; break; }
+    }
+    if (dst) {
+      if (dst->bssids < 255) dst->bssids++;
+      if (rssi <= dst->rssi) continue;
+    } else if (scanResults.size() < AWM_SCAN_MAX_RESULTS) {
+      scanResults.push_back(ScanEntry());
+      dst = &scanResults.back();
+      strlcpy(dst->ssid, s.c_str(), sizeof(dst->ssid));
+      dst->bssids = 1;
+    } else {
+      auto weakest = std::min_element(scanResults.begin(), scanResults.end(),
+        [](const ScanEntry& a, const ScanEntry& b){ return a.rssi < b.rssi; });
+      if (rssi <= weakest->rssi) continue;
+      dst = &*weakest;
+      strlcpy(dst->ssid, s.c_str(), sizeof(dst->ssid));
+      dst->bssids = 1;
+    }
+    dst->rssi    = rssi;
+    dst->channel = (uint8_t)WiFi.channel(i);
+    dst->secure  = (WiFi.encryptionType(i) != WIFI_AUTH_OPEN);
   }
 
   WiFi.scanDelete(); // limpiar resultados en RAM
-  scanning = false;
 
-  String out;
-  serializeJson(arr, out);
-  server.send(200, "application/json", out);
-  AWM_LOGI("✅ Escaneo OK: %d redes", (int)arr.size());
+  std::sort(scanResults.begin(), scanResults.end(),
+            [](const ScanEntry& a, const ScanEntry& b){ return a.rssi > b.rssi; });
+
+  scanHasResult = true;
+  lastScanAt    = millis();
+  AWM_LOGI("✅ Escaneo OK: %d redes de %d BSSID (%lu ms) · requests/escaneos = %lu/%lu",
+           (int)scanResults.size(), n, (unsigned long)(lastScanAt - scanStartedAt),
+           (unsigned long)scanStats.requests, (unsigned long)scanStats.scans);
+
+  sseEnviarEscaneo();
+}
+
+// =====================================================
+//              SSE: /events (push al portal)
+// =====================================================
+// Una conexión abierta por pestaña del portal; update() empuja:
+//   event: scan    → [{ssid,rssi,...}] al terminar cada escaneo
+//   event: link    → {"state":"connecting|connected|failed|disconnected",...}
+//   event: portal  → {"remaining_s":N} (cuenta regresiva del timeout)
+// Mientras haya suscriptores se re-escanea cada SSE_SCAN_INTERVAL_MS, así la
+// página no necesita hacer polling de /scan.
+
+// Escritura sin espera a un suscriptor: todo o nada. En ESP32 write() reintenta
+// con select() por segundos si la ventana TCP está llena → send() no
+// bloqueante sobre el socket. En ESP8266, solo si el buffer de envío alcanza
+// (write() igual respeta SSE_WRITE_TIMEOUT_MS). false = descartar al cliente.
+static bool sseEscribir(WiFiClient& c, const void* p, size_t n) {
+#if defined(ESP32)
+  const int fd = c.fd();
+  return fd >= 0 && send(fd, p, n, MSG_DONTWAIT) == (ssize_t)n;
+#else
+  return c.availableForWrite() >= (int)n &&
+         c.write(static_cast<const uint8_t*>(p), n) == n;
+#endif
+}
+
+void AyresWiFiManager::handleEvents() {
+  lastHttpAccess = millis();
+
+  WiFiClient* slot = nullptr;
+  for (auto& c : sseClients) {
+    if (!c.connected()) { c.stop(); slot = &c; break; }
+  }
+  if (!slot) {
+    server.send(503, "text/plain", "Demasiados clientes");
+    return;
+  }
+
+  // Respuesta "a mano": el WebServer no soporta respuestas sin fin. Nos
+  // quedamos con una copia del socket y el servidor suelta la suya.
+  *slot = server.client();
+  slot->setNoDelay(true);
+#if defined(ESP8266)
+  slot->setTimeout(SSE_WRITE_TIMEOUT_MS);   // write() no espera más que esto
+#endif
+  static const char CABECERA[] = "HTTP/1.1 200 OK\r\n"
+                                 "Content-Type: text/event-stream\r\n"
+                                 "Cache-Control: no-cache\r\n"
+                                 "Connection: close\r\n\r\n"
+                                 "retry: 3000\n\n";
+  if (!sseEscribir(*slot, CABECERA, sizeof(CABECERA) - 1)) {
+    slot->stop();
+    return;
+  }
+  AWM_LOGD("📡 SSE: cliente suscripto (%u activos)", sseClientes());
+
+  // Estado inicial solo para el nuevo suscriptor
+  if (scanHasResult) sseEnviarEscaneo(slot);
+  else               iniciarEscaneo();
+  if (provEstado != PROV_IDLE) sseEstadoProvision(slot);
+  else sseEstadoConexion(enlaceConIp() ? "connected" : "disconnected", slot);
+}
+
+uint8_t AyresWiFiManager::sseClientes() {
+  uint8_t n = 0;
+  for (auto& c : sseClients) if (c.connected()) n++;
+  return n;
+}
+
+void AyresWiFiManager::sseCerrarTodos() {
+  for (auto& c : sseClients) c.stop();
+}
+
+// Escribe "event: <evento>\ndata: <json>\n\n" a todos los suscriptores (o solo
+// a 'solo'). El JSON se genera en streaming; si un cliente no acepta todos los
+// bytes de un tramo sin esperar (colgado, lento o desconectado) se lo descarta:
+// un evento a medias ya no se puede completar.
+void AyresWiFiManager::sseEnviar(const char* evento,
+                                 const std::function<void(AwmJsonWriter&)>& data,
+                                 WiFiClient* solo) {
+  struct Destino { WiFiClient* c; bool ok; };
+  for (auto& c : sseClients) {
+    if (solo && &c != solo) continue;
+    if (!c.connected()) continue;
+
+    Destino d = { &c, true };
+    AwmJsonWriter w([](void* ctx, const char* p, size_t n){
+      Destino* d = static_cast<Destino*>(ctx);
+      if (d->ok && !sseEscribir(*d->c, p, n)) d->ok = false;
+    }, &d);
+    w.raw("event: "); w.raw(evento); w.raw("\ndata: ");
+    data(w);
+    w.raw("\n\n");
+    w.flush();
+
+    if (!d.ok) {
+      AWM_LOGD("📡 SSE: cliente descartado (write falló)");
+      c.stop();
+    }
+  }
+}
+
+void AyresWiFiManager::sseEnviarEscaneo(WiFiClient* solo) {
+  if (!scanHasResult) return;
+  sseEnviar("scan", [this](AwmJsonWriter& w){
+    escribirEscaneoJson(w, scanResults.size(), -128);
+  }, solo);
+}
+
+void AyresWiFiManager::sseEstadoConexion(const char* estado, WiFiClient* solo) {
+  if (!portalActive) return;
+  sseEnviar("link", [&](AwmJsonWriter& w){
+    w.raw("{\"state\":"); w.str(estado);
+    w.raw(",\"ssid\":");  w.str(ssid.c_str());
+    if (linkEstado == LinkState::GOT_IP) {
+      w.raw(",\"ip\":"); w.str(WiFi.localIP().toString().c_str());
+    }
+    w.raw('}');
+  }, solo);
+}
+
+// Evento "link" con el progreso de /save (mismo JSON que GET /status).
+void AyresWiFiManager::sseEstadoProvision(WiFiClient* solo) {
+  if (!portalActive) return;
+  sseEnviar("link", [this](AwmJsonWriter& w){ escribirEstadoProvision(w); }, solo);
+}
+
+// Llamado desde update(): mantenimiento de suscriptores a 1 Hz.
+void AyresWiFiManager::sseTask() {
+  if (!portalActive) return;
+  const unsigned long now = millis();
+  if (now - sseLastTick < 1000) return;
+  sseLastTick = now;
+
+  if (sseClientes() == 0) return;
+
+  // Una pestaña abierta cuenta como uso del portal (ya no hay polling HTTP)
+  if (webClientCheck) lastHttpAccess = now;
+
+  // Re-escaneo periódico mientras alguien mira la lista
+  if (!scanning && (!scanHasResult || now - lastScanAt >= SSE_SCAN_INTERVAL_MS)) {
+    iniciarEscaneo();
+  }
+
+  // Cuenta regresiva del portal (o keep-alive si no hay timeout)
+  if (portalTimeoutMs) {
+    const unsigned long base = webClientCheck ? lastHttpAccess : portalStart;
+    const unsigned long used = now - base;
+    const unsigned long rest = (used >= portalTimeoutMs) ? 0 : (portalTimeoutMs - used);
+    sseEnviar("portal", [rest](AwmJsonWriter& w){
+      w.raw("{\"remaining_s\":"); w.num((long)(rest / 1000)); w.raw('}');
+    });
+  } else if (now - sseLastPing >= SSE_PING_MS) {
+    sseLastPing = now;
+    for (auto& c : sseClients) {
+      if (c.connected() && !sseEscribir(c, ": ping\n\n", 8)) c.stop();
+    }
+  }
 }
 
 void AyresWiFiManager::handleNotFound() {
@@ -522,20 +1141,63 @@ void AyresWiFiManager::handleNotFound() {
 }
 
 void AyresWiFiManager::mostrarPaginaError(const String& mensajeFallback) {
-  File errorFile = LittleFS.open(htmlPathPrefix + "error.html", "r");
-  if (!errorFile) {
+  if (!enviarPagina(PAG_ERROR, 500)) {
     server.send(500, "text/html", "<h1>Error: " + mensajeFallback + "</h1>");
-  } else {
-    server.send(500, "text/html", errorFile.readString());
-    errorFile.close();
   }
 }
 
+// Página del portal: primero el bundle embebido en flash (si se compiló con
+// AWM_EMBED_PORTAL=1), luego LittleFS (htmlPathPrefix + nombre).
+// Solo los GET 200 llevan ETag/Cache-Control (las respuestas a /save no se cachean).
+bool AyresWiFiManager::enviarPagina(Pagina p, int code) {
+  static const char* const kNombres[PAG_COUNT] = { "index.html", "success.html", "error.html" };
+  const bool cacheable = (code == 200 && server.method() == HTTP_GET);
+
+#if AWM_EMBED_PORTAL
+  const AwmEmbeddedAsset& a = AWM_PORTAL_ASSETS[p];
+  if (a.data) {
+    // Un navegador sin gzip (raro) prueba primero el archivo plano de LittleFS.
+    if (a.gzip && !AwmAssets::acceptsGzip(server) &&
+        enviarArchivo(htmlPathPrefix + kNombres[p], "text/html", code, cacheable)) return true;
+    if (a.gzip) server.sendHeader("Vary", "Accept-Encoding");
+    if (cacheable && AwmAssets::notModified(server, a.etag)) return true;
+    if (a.gzip) server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(code, PSTR("text/html"), reinterpret_cast<PGM_P>(a.data), a.len);
+    return true;
+  }
+#endif
+
+  return enviarArchivo(htmlPathPrefix + kNombres[p], "text/html", code, cacheable);
+}
+
+// Página de LittleFS por bloques de AWM_STREAM_CHUNK bytes, con variante .gz
+// y ETag/304 (ver AWM_Asset.h).
+// Devuelve false (sin enviar nada) si el archivo no existe o no se puede abrir.
+bool AyresWiFiManager::enviarArchivo(const String& path, const char* contentType,
+                                     int code, bool cacheable) {
+  return assets.send(server, LittleFS, path, contentType, code, cacheable);
+}
+
 // =====================================================
 //                    CREDENCIALES
 // =====================================================
 bool AyresWiFiManager::tieneCredenciales() const {
-  return LittleFS.exists("/wifi.json") && !ssid.isEmpty() && !password.isEmpty();
+  return LittleFS.exists("/wifi.json") && !redes.empty();
+}
+
+// Capacidad de /wifi.json: por red ~7 campos + ssid/psk/bssid copiados al leer
+static constexpr size_t WIFI_JSON_CAP = 128 + AWM_MAX_NETWORKS * 256;
+
+// PBKDF2 completo de una vez (carga/migración y addNetwork): ~1 s en ESP8266.
+static String derivarPsk(const char* pass, const char* ssid) {
+  const unsigned long t0 = millis();
+  AwmPmk pmk;
+  pmk.begin(pass, ssid);
+  while (!pmk.step(256)) yield();
+  char psk[65];
+  pmk.hex(psk);
+  AWM_LOGI("🔑 PMK derivada de la passphrase en %lu ms", (unsigned long)(millis() - t0));
+  return String(psk);
 }
 
 void AyresWiFiManager::loadCredentials() {
@@ -548,7 +1210,7 @@ void AyresWiFiManager::loadCredentials() {
     AWM_LOGE("❌ No se pudo abrir /wifi.json");
     return;
   }
-  StaticJsonDocument<192> doc;
+  DynamicJsonDocument doc(WIFI_JSON_CAP);
   DeserializationError error = deserializeJson(doc, file);
   file.close();
   if (error) {
@@ -556,21 +1218,97 @@ void AyresWiFiManager::loadCredentials() {
     return;
   }
 
-  String loadedSsid = doc["ssid"].as<String>();
-  String loadedPassword = doc["password"].as<String>();
-  if (loadedSsid.isEmpty() || loadedPassword.isEmpty()) {
+  // Una entrada: "psk" (64 hex) o "password" (clave que no es passphrase WPA,
+  // tal cual). Archivos viejos traen la passphrase en "password" → migrar
+  bool migrar = false;
+  auto cargar = [&](JsonVariant o) {
+    const char* s    = o["ssid"] | "";
+    const char* psk  = o["psk"] | "";
+    const char* pass = o["password"] | "";
+    if (!*s || (!*psk && !*pass) || redes.size() >= AWM_MAX_NETWORKS) return;
+
+    Red r;
+    r.ssid = s;
+    if (AwmPmk::esHex(psk)) {
+      r.psk = psk;
+    } else if (AwmPmk::esHex(pass)) {
+      r.psk  = pass;
+      migrar = true;
+    } else if (esPassphraseWpa(pass)) {
+      // Única vez: PBKDF2 (4096 iteraciones) que si no haría el driver en cada begin()
+      r.psk  = derivarPsk(pass, s);
+      migrar = true;
+    } else {
+      r.psk = pass;   // WEP u otra: el driver necesita la clave original
+    }
+    r.prio = o["prio"] | 0;
+    r.ok   = o["ok"] | 0u;
+    r.ms   = o["ms"] | 0u;
+
+    // Pista de asociación (opcional; archivos viejos no la tienen)
+    unsigned int b[6];
+    const char* bssidTxt = o["bssid"] | "";
+    const uint8_t canal  = o["channel"] | 0;
+    if (canal > 0 &&
+        sscanf(bssidTxt, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) == 6) {
+      for (int i = 0; i < 6; i++) r.bssid[i] = (uint8_t)b[i];
+      r.canal = canal;
+    }
+    redes.push_back(r);
+  };
+
+  redes.clear();
+  JsonArray lista = doc["networks"];
+  if (lista.isNull()) {
+    cargar(doc.as<JsonVariant>());   // formato de una sola red (≤ 2.0.2)
+    if (!redes.empty()) {
+      ultimaRed = redes[0].ssid;
+      migrar    = true;
+    }
+  } else {
+    for (JsonVariant o : lista) cargar(o);
+    ultimaRed = doc["last"] | "";
+  }
+  if (redes.empty()) {
     AWM_LOGW("⚠️ Credenciales vacías en archivo.");
     return;
   }
-  ssid     = loadedSsid;
-  password = loadedPassword;
-  AWM_LOGI("✅ Credenciales cargadas (SSID=\"%s\").", ssid.c_str());
+
+  int i = indiceRed(ultimaRed);
+  if (i < 0) i = 0;
+  seleccionarRed(i);
+
+  AWM_LOGI("✅ Credenciales cargadas: %u red(es), activa \"%s\"%s.", (unsigned)redes.size(),
+           ssid.c_str(), pistaValida ? " con BSSID/canal" : "");
+
+  if (migrar) {
+    saveCredentials();
+    AWM_LOGI("🔑 /wifi.json migrado al formato de lista con PSK");
+  }
 }
 
-void AyresWiFiManager::saveCredentials(String s, String p) {
-  StaticJsonDocument<192> doc;
-  doc["ssid"]     = s;
-  doc["password"] = p;
+// /wifi.json: {"networks":[{ssid,psk|password,prio,ok,ms,bssid,channel},...],"last":"<ssid>"}
+void AyresWiFiManager::saveCredentials() {
+  DynamicJsonDocument doc(WIFI_JSON_CAP);
+  JsonArray lista = doc.createNestedArray("networks");
+  for (const Red& r : redes) {
+    JsonObject o = lista.createNestedObject();
+    o["ssid"] = r.ssid.c_str();
+    // PSK 64 hex: begin() no corre PBKDF2 y la passphrase no queda en flash
+    o[AwmPmk::esHex(r.psk.c_str()) ? "psk" : "password"] = r.psk.c_str();
+    if (r.prio) o["prio"] = r.prio;
+    if (r.ok)   o["ok"]   = r.ok;
+    if (r.ms)   o["ms"]   = r.ms;
+    if (r.canal) {
+      char bssidTxt[18];
+      snprintf(bssidTxt, sizeof(bssidTxt), "%02x:%02x:%02x:%02x:%02x:%02x",
+               r.bssid[0], r.bssid[1], r.bssid[2], r.bssid[3], r.bssid[4], r.bssid[5]);
+      o["bssid"]   = bssidTxt;
+      o["channel"] = r.canal;
+    }
+  }
+  if (!ultimaRed.isEmpty()) doc["last"] = ultimaRed.c_str();
+
   File file = LittleFS.open("/wifi.json", "w");
   if (!file) {
     AWM_LOGE("❌ Error abriendo /wifi.json para escritura");
@@ -580,6 +1318,328 @@ void AyresWiFiManager::saveCredentials(String s, String p) {
   file.close();
 }
 
+int AyresWiFiManager::indiceRed(const String& s) const {
+  for (size_t i = 0; i < redes.size(); i++) if (redes[i].ssid == s) return (int)i;
+  return -1;
+}
+
+// Alta o actualización en memoria (no escribe). prio < 0 conserva la de una
+// red existente (0 si es nueva). Con la lista llena se descarta la de menor
+// prioridad y, a igual prioridad, la de éxito más antiguo.
+int AyresWiFiManager::agregarRed(const String& s, const String& psk, int prio) {
+  int i = indiceRed(s);
+  if (i < 0) {
+    if (redes.size() >= AWM_MAX_NETWORKS) {
+      auto peor = std::min_element(redes.begin(), redes.end(), [](const Red& a, const Red& b) {
+        return a.prio != b.prio ? a.prio < b.prio : a.ok < b.ok;
+      });
+      AWM_LOGI("🗂️ Lista de redes llena: se descarta \"%s\"", peor->ssid.c_str());
+      if (peor->ssid == ultimaRed) ultimaRed = String();
+      redes.erase(peor);
+    }
+    redes.push_back(Red());
+    i = (int)redes.size() - 1;
+    redes[i].ssid = s;
+  } else if (redes[i].psk != psk) {
+    redes[i].canal = 0;   // otra clave: la pista y el historial ya no valen
+    redes[i].ms    = 0;
+  }
+  redes[i].psk    = psk;
+  redes[i].fallos = 0;
+  if (prio >= 0) redes[i].prio = (uint8_t)prio;
+  redActual = indiceRed(ssid);   // los índices pudieron correrse
+  return i;
+}
+
+// Copia la red i a ssid/password/pista (lo que usan begin() y el resto del código).
+void AyresWiFiManager::seleccionarRed(int i) {
+  const Red& r = redes[i];
+  redActual   = i;
+  ssid        = r.ssid;
+  password    = r.psk;
+  pistaCanal  = r.canal;
+  pistaValida = r.canal > 0;
+  memcpy(pistaBssid, r.bssid, 6);
+}
+
+// Tras asociar: guarda BSSID/canal del AP, el tiempo de asociación y la hora
+// del éxito en la red activa. Solo escribe si algo cambió de verdad (pista
+// distinta, tiempo >25% distinto, otra red, éxito con más de un día): un nodo
+// que despierta seguido no reescribe flash en cada conexión. Devuelve true si
+// reescribió /wifi.json.
+bool AyresWiFiManager::recordarRed(uint32_t assocMs) {
+  if (redActual < 0) return false;
+  Red& r = redes[redActual];
+  r.fallos = 0;
+  bool cambio = false;
+
+  const uint8_t* b  = WiFi.BSSID();
+  const int32_t  ch = WiFi.channel();
+  if (b && ch > 0 && ch <= 14 && (r.canal != ch || memcmp(r.bssid, b, 6) != 0)) {
+    memcpy(r.bssid, b, 6);
+    r.canal = (uint8_t)ch;
+    cambio  = true;
+    AWM_LOGD("📌 Pista de asociación: %s canal %u", WiFi.BSSIDstr().c_str(), r.canal);
+  }
+  const uint32_t d = assocMs > r.ms ? assocMs - r.ms : r.ms - assocMs;
+  if (!r.ms || d * 4 > r.ms) {
+    r.ms   = assocMs;
+    cambio = true;
+  }
+  const time_t now = time(nullptr);
+  if (now > 100000 && (uint32_t)now - r.ok > 86400) {
+    r.ok   = (uint32_t)now;
+    cambio = true;
+  }
+  if (ultimaRed != r.ssid) {
+    ultimaRed = r.ssid;
+    cambio    = true;
+  }
+  seleccionarRed(redActual);
+  if (cambio) saveCredentials();
+  return cambio;
+}
+
+bool AyresWiFiManager::addNetwork(const String& s, const String& pass, uint8_t priority) {
+  if (s.isEmpty() || s.length() > 32 || pass.isEmpty()) {
+    AWM_LOGW("⚠️ addNetwork: SSID o contraseña inválidos");
+    return false;
+  }
+  // Solo una passphrase WPA se cambia por su PMK; PSK hex o WEP van tal cual
+  const bool derivar = !AwmPmk::esHex(pass.c_str()) && esPassphraseWpa(pass.c_str());
+  const int i = agregarRed(s, derivar ? derivarPsk(pass.c_str(), s.c_str()) : pass, priority);
+  if (redActual < 0) seleccionarRed(i);
+  saveCredentials();
+  AWM_LOGI("🗂️ Red \"%s\" guardada (prioridad %u, %u/%u)", s.c_str(), priority,
+           (unsigned)redes.size(), (unsigned)AWM_MAX_NETWORKS);
+  return true;
+}
+
+bool AyresWiFiManager::removeNetwork(const String& s) {
+  const int i = indiceRed(s);
+  if (i < 0) return false;
+  redes.erase(redes.begin() + i);
+  if (ultimaRed == s) ultimaRed = String();
+  redActual = indiceRed(ssid);
+  if (redActual < 0 && !redes.empty()) seleccionarRed(0);
+  saveCredentials();
+  AWM_LOGI("🗂️ Red \"%s\" eliminada (%u restantes)", s.c_str(), (unsigned)redes.size());
+  return true;
+}
+
+uint8_t AyresWiFiManager::getNetworkCount() const { return (uint8_t)redes.size(); }
+
+// =====================================================
+//                 LEASE DHCP CACHEADO
+// =====================================================
+// ARP al gateway: la forma más barata de saber si la IP estática sirve en esta
+// red sin bloquear (la respuesta la procesa lwIP; acá solo se mira la tabla).
+// De paso se pregunta por la propia IP (detección de duplicada). lwIP no
+// guarda su propia dirección en la tabla ARP, así que la respuesta de otro
+// equipo se mira al entrar: mientras dura la sonda, netif->input pasa por
+// arpEntrada(), que solo lee y sigue al input original.
+// En ESP32 lwIP corre en su propia tarea → se entra vía tcpip_try_callback(),
+// con un solo paso en vuelo: local/gw se publican antes de encolarlo y no se
+// tocan hasta que el paso baje enCurso; lwIP y el driver solo escriben
+// visto/conflicto.
+struct ArpSonda {
+  uint32_t local, gw;
+#if defined(ESP32)
+  std::atomic<bool> enCurso, visto, conflicto;
+#else
+  bool enCurso, visto, conflicto;
+#endif
+};
+static ArpSonda arpSonda = { 0, 0, {false}, {false}, {false} };
+
+static netif_input_fn arpInputOriginal = nullptr;
+static struct netif*  arpNetif         = nullptr;
+
+// Toda trama entrante mientras dura la sonda (en ESP32, desde la tarea del
+// driver). ARP (pedido o respuesta) con IP de origen = la del lease y una MAC
+// que no es la nuestra → otro equipo la usa.
+static err_t arpEntrada(struct pbuf* p, struct netif* n) {
+  const uint8_t* f = static_cast<const uint8_t*>(p->payload);
+  if (p->len >= 42 && f[12] == 0x08 && f[13] == 0x06) {   // Ethernet + ARP IPv4
+    uint32_t origen;
+    memcpy(&origen, f + 28, 4);                            // sender IP
+    if (origen == arpSonda.local && memcmp(f + 22, n->hwaddr, 6) != 0) arpSonda.conflicto = true;
+  }
+  return arpInputOriginal(p, n);
+}
+
+static void arpRestaurar(void*) {
+  if (arpNetif && arpNetif->input == arpEntrada) arpNetif->input = arpInputOriginal;
+  arpNetif = nullptr;
+}
+
+static void arpPaso(void*) {
+  struct netif* n = netif_list;
+  while (n && ip4_addr_get_u32(netif_ip4_addr(n)) != arpSonda.local) n = n->next;
+  if (n) {
+    if (n->input != arpEntrada) {
+      arpRestaurar(nullptr);
+      arpInputOriginal = n->input;
+      arpNetif         = n;
+      n->input         = arpEntrada;
+    }
+    ip4_addr_t gw, propia;
+    ip4_addr_set_u32(&gw, arpSonda.gw);
+    ip4_addr_set_u32(&propia, arpSonda.local);
+    struct eth_addr* mac = nullptr;
+    const ip4_addr_t* ip = nullptr;
+    if (!arpSonda.visto && etharp_find_addr(n, &gw, &mac, &ip) >= 0) arpSonda.visto = true;
+    if (!arpSonda.visto) etharp_request(n, &gw);
+    etharp_request(n, &propia);
+  }
+  arpSonda.enCurso = false;
+}
+
+// true si la MAC del gateway ya está en la tabla ARP. Con enviar=true (el
+// llamador lo acota a uno cada LEASE_ARP_EVERY_MS) relee la tabla y vuelve a
+// preguntar; si no, solo devuelve lo último visto. No espera: la respuesta se
+// ve en un paso posterior.
+static bool gatewayRespondeArp(uint32_t local, uint32_t gw, bool enviar) {
+  if (arpSonda.enCurso) return arpSonda.visto;   // paso anterior todavía en lwIP
+  if (arpSonda.local != local || arpSonda.gw != gw) {
+    arpSonda.local = local; arpSonda.gw = gw;
+    arpSonda.visto = false; arpSonda.conflicto = false;
+  }
+  if (!enviar) return arpSonda.visto;
+  arpSonda.enCurso = true;
+#if defined(ESP32)
+  if (tcpip_try_callback(arpPaso, nullptr) != ERR_OK) arpSonda.enCurso = false;   // cola llena
+#else
+  arpPaso(nullptr);   // ESP8266: lwIP corre en el mismo contexto que loop()
+#endif
+  return arpSonda.visto;
+}
+
+// true si otro equipo respondió por la IP del lease (ver arpEntrada).
+static bool ipPropiaEnUso() { return arpSonda.conflicto; }
+
+// Fin de la sonda: netif->input vuelve a ser el de lwIP.
+static void arpSondaTerminar() {
+#if defined(ESP32)
+  tcpip_callback(arpRestaurar, nullptr);
+#else
+  arpRestaurar(nullptr);
+#endif
+}
+
+void AyresWiFiManager::cargarLease() {
+  leaseCargado = true;
+  leaseValido  = false;
+  if (!LittleFS.exists("/lease.json")) return;
+  File file = LittleFS.open("/lease.json", "r");
+  if (!file) return;
+  StaticJsonDocument<256> doc;
+  DeserializationError error = deserializeJson(doc, file);
+  file.close();
+  if (error) {
+    AWM_LOGW("⚠️ /lease.json inválido → DHCP");
+    return;
+  }
+
+  IPAddress ip, gw, mask, dns1, dns2;
+  if (!ip.fromString(doc["ip"] | "") || !gw.fromString(doc["gw"] | "") ||
+      !mask.fromString(doc["mask"] | "")) {
+    return;
+  }
+  dns1.fromString(doc["dns1"] | "");
+  dns2.fromString(doc["dns2"] | "");
+  lease.ssid = doc["ssid"] | "";
+  lease.ip   = (uint32_t)ip;   lease.gw   = (uint32_t)gw;   lease.mask = (uint32_t)mask;
+  lease.dns1 = (uint32_t)dns1; lease.dns2 = (uint32_t)dns2;
+  lease.t    = doc["t"] | 0;
+
+  // Vencimiento: solo evaluable con hora válida (en ESP32 sobrevive al deep
+  // sleep; en ESP8266 la repone restaurarHoraRtc). Sin ella, o sin fecha del
+  // lease, su edad es desconocida y no se usa: DHCP lo reemplaza.
+  const time_t now = time(nullptr);
+  if (leaseMaxAgeS && (!lease.t || now <= 100000)) {
+    AWM_LOGI("📇 Lease cacheado sin edad verificable (falta hora) → DHCP");
+    return;
+  }
+  if (leaseMaxAgeS && (uint32_t)now - lease.t > leaseMaxAgeS) {
+    AWM_LOGI("📇 Lease cacheado vencido → DHCP");
+    borrarLease();
+    return;
+  }
+  leaseValido   = true;
+  leaseRevisado = (lease.t != 0);
+  AWM_LOGI("📇 Lease cacheado: %s gw %s (\"%s\")", ip.toString().c_str(),
+           gw.toString().c_str(), lease.ssid.c_str());
+}
+
+// Tras un DHCP exitoso: recordar el lease (solo escribe si cambió).
+void AyresWiFiManager::capturarLease() {
+  if (!leaseOn) return;
+  Lease l;
+  l.ssid = ssid;
+  l.ip   = (uint32_t)WiFi.localIP();
+  l.gw   = (uint32_t)WiFi.gatewayIP();
+  l.mask = (uint32_t)WiFi.subnetMask();
+  l.dns1 = (uint32_t)WiFi.dnsIP(0);
+  l.dns2 = (uint32_t)WiFi.dnsIP(1);
+  if (!l.ip || !l.gw) return;
+
+  if (leaseValido && lease.ssid == l.ssid && lease.ip == l.ip && lease.gw == l.gw &&
+      lease.mask == l.mask && lease.dns1 == l.dns1 && lease.dns2 == l.dns2) {
+    return;   // mismo lease: conservar su fecha original
+  }
+  const time_t now = time(nullptr);
+  l.t = (now > 100000) ? (uint32_t)now : 0;
+  leaseCapturaMs = millis();   // sin hora: leaseTask lo fecha con esta referencia
+  lease        = l;
+  leaseValido  = true;
+  leaseCargado = true;
+  leaseRevisado = (l.t != 0);
+  guardarLease();
+}
+
+void AyresWiFiManager::guardarLease() {
+  StaticJsonDocument<256> doc;
+  doc["ssid"] = lease.ssid;
+  doc["ip"]   = IPAddress(lease.ip).toString();
+  doc["gw"]   = IPAddress(lease.gw).toString();
+  doc["mask"] = IPAddress(lease.mask).toString();
+  doc["dns1"] = IPAddress(lease.dns1).toString();
+  doc["dns2"] = IPAddress(lease.dns2).toString();
+  doc["t"]    = lease.t;
+  File file = LittleFS.open("/lease.json", "w");
+  if (!file) {
+    AWM_LOGE("❌ Error abriendo /lease.json para escritura");
+    return;
+  }
+  serializeJson(doc, file);
+  file.close();
+  AWM_LOGD("📇 Lease guardado: %s", IPAddress(lease.ip).toString().c_str());
+}
+
+void AyresWiFiManager::borrarLease() {
+  leaseValido = false;
+  if (LittleFS.exists("/lease.json")) LittleFS.remove("/lease.json");
+}
+
+// Llamado desde update(): fecha el lease y evalúa su vencimiento una vez que
+// hay hora válida (al capturarlo en el arranque NTP todavía no respondió). La
+// fecha se corre hacia atrás lo que pasó desde la captura (millis()).
+void AyresWiFiManager::leaseTask() {
+  if (!leaseOn || !leaseValido || leaseRevisado) return;
+  const time_t now = time(nullptr);
+  if (now <= 100000) return;
+  leaseRevisado = true;
+
+  if (lease.t == 0) {
+    lease.t = (uint32_t)now - (uint32_t)((millis() - leaseCapturaMs) / 1000);
+    guardarLease();
+  } else if (leaseMaxAgeS && (uint32_t)now - lease.t > leaseMaxAgeS) {
+    AWM_LOGI("📇 Lease cacheado vencido → DHCP en la próxima conexión");
+    borrarLease();
+  }
+}
+
 void AyresWiFiManager::eraseCredentials() {
   eraseJsonInDir("/");   // raíz
 
@@ -591,96 +1651,555 @@ void AyresWiFiManager::eraseCredentials() {
 }
 
 // =====================================================
-//                     CONEXIÓN STA
+//                 ENLACE STA (EVENTOS)
 // =====================================================
-bool AyresWiFiManager::connectToWiFi() {
-  if (!tieneCredenciales()) return false;
+// Los eventos del core dejan el estado en linkEstado (una escritura atómica);
+// el resto del código lo lee sin llamar a WiFi.status() en cada vuelta.
+// STA_DISCONNECTED deja además su reason en linkMotivo (antes que el estado).
 
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(ssid.c_str(), password.c_str());
+// Mismos códigos (802.11 + extensiones de Espressif) en ambos cores.
+#if defined(ESP32)
+  #define AWM_MOTIVO(n) WIFI_REASON_##n
+#else
+  #define AWM_MOTIVO(n) WIFI_DISCONNECT_REASON_##n
+#endif
 
-  AWM_LOGI("Conectando a %s", ssid.c_str());
+static AyresWiFiManager::DisconnectClass clasificarMotivo(uint8_t motivo) {
+  using C = AyresWiFiManager::DisconnectClass;
+  switch (motivo) {
+    case 0:
+    case AWM_MOTIVO(ASSOC_LEAVE):            return C::NONE;    // disconnect()/begin() propios
+    case AWM_MOTIVO(AUTH_FAIL):              return C::AUTH;    // MIC_FAILURE no: contramedida TKIP, pasajera
+    case AWM_MOTIVO(NO_AP_FOUND):            return C::NO_AP;
+    case AWM_MOTIVO(BEACON_TIMEOUT):         return C::BEACON;
+    case AWM_MOTIVO(4WAY_HANDSHAKE_TIMEOUT):
+    case AWM_MOTIVO(GROUP_KEY_UPDATE_TIMEOUT):
+    case AWM_MOTIVO(HANDSHAKE_TIMEOUT):      return C::HANDSHAKE;
+    default:                                 return C::OTHER;
+  }
+}
 
-  const uint32_t TOUT_MS = 15000;
-  uint32_t t0 = millis();
-  while (millis() - t0 < TOUT_MS) {
-    if (WiFi.status() == WL_CONNECTED) {
-      AWM_LOGI("Conectado. IP: %s", WiFi.localIP().toString().c_str());
+static const char* nombreClase(AyresWiFiManager::DisconnectClass c) {
+  using C = AyresWiFiManager::DisconnectClass;
+  switch (c) {
+    case C::AUTH:      return "auth";
+    case C::NO_AP:     return "no_ap";
+    case C::BEACON:    return "beacon";
+    case C::HANDSHAKE: return "handshake";
+    case C::OTHER:     return "other";
+    default:           return "none";
+  }
+}
+
+void AyresWiFiManager::registrarEventosWiFi() {
+  if (eventosOn) return;
+  eventosOn = true;
 #if defined(ESP32)
-      WiFi.setSleep(false);
+  WiFi.onEvent([this](arduino_event_id_t, arduino_event_info_t) {
+    linkEstado = LinkState::ASSOCIATED;
+  }, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+  WiFi.onEvent([this](arduino_event_id_t, arduino_event_info_t) {
+    linkEstado = LinkState::GOT_IP;
+  }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  WiFi.onEvent([this](arduino_event_id_t, arduino_event_info_t) {
+    linkEstado = LinkState::ASSOCIATED;
+  }, ARDUINO_EVENT_WIFI_STA_LOST_IP);
+  WiFi.onEvent([this](arduino_event_id_t, arduino_event_info_t info) {
+    linkMotivo = info.wifi_sta_disconnected.reason;
+    linkEstado = LinkState::DOWN;
+  }, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+#else
+  evAsociado = WiFi.onStationModeConnected([this](const WiFiEventStationModeConnected&) {
+    linkEstado = LinkState::ASSOCIATED;
+  });
+  evConIp = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP&) {
+    linkEstado = LinkState::GOT_IP;
+  });
+  evDesconectado = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected& ev) {
+    linkMotivo = (uint8_t)ev.reason;
+    linkEstado = LinkState::DOWN;
+  });
 #endif
-      connected = true;
-      return true;
+  linkEstado   = (WiFi.status() == WL_CONNECTED) ? LinkState::GOT_IP : LinkState::DOWN;
+  linkSondeoAt = millis();
+}
+
+// Enlace con IP según los eventos. Como respaldo, cada LINK_SONDEO_MS se
+// contrasta con WiFi.status() (un evento perdido, o begin() sobre la misma red
+// ya asociada, que no genera eventos nuevos). Sin begin() todavía, solo sondeo.
+bool AyresWiFiManager::enlaceConIp() {
+  if (!eventosOn || millis() - linkSondeoAt >= LINK_SONDEO_MS) {
+    linkSondeoAt = millis();
+    const bool ip = (WiFi.status() == WL_CONNECTED);
+    if (ip != (linkEstado == LinkState::GOT_IP)) {
+      linkEstado = ip ? LinkState::GOT_IP : LinkState::DOWN;
     }
-    delay(250);
   }
+  return linkEstado == LinkState::GOT_IP;
+}
 
-  AWM_LOGW("⏱️ Tiempo agotado. No se pudo conectar.");
-  connected = false;
-  return false;
+// Llamado desde update(): entrega los cambios de enlace (callback del usuario
+// y SSE "link") en el contexto de loop(), nunca desde la tarea de eventos.
+void AyresWiFiManager::linkTask() {
+  const uint8_t motivo = linkMotivo;
+  if (motivo) ultimoMotivo = motivo;
+  const LinkState e = linkEstado;
+  if (e == linkAvisado) return;
+  const bool teniaIp = (linkAvisado == LinkState::GOT_IP);
+  linkAvisado = e;
+  connected   = (e == LinkState::GOT_IP);
+  AWM_LOGD("🔗 Enlace STA: %s", e == LinkState::GOT_IP ? "con IP" :
+           e == LinkState::ASSOCIATED ? "asociado" : "caído");
+
+  // Caída: empieza al perder la IP por un motivo del driver (no por un
+  // disconnect/begin propio) y termina al recuperarla.
+  if (teniaIp && !connected && caidaAt == 0) {
+    const DisconnectClass c = clasificarMotivo(motivo);
+    if (c != DisconnectClass::NONE) {
+      caidaAt    = millis();
+      caidaClase = c;
+      AWM_LOGW("📉 Enlace caído: motivo %u (%s)", motivo, nombreClase(c));
+      salud.disconnect();
+      if (connState != ConnectState::CONNECTING && provEstado != PROV_PROBANDO) estrategiaCaida(c, false);
+    }
+  } else if (connected) {
+    if (caidaAt) {
+      RecoveryStats& r = recStats[(uint8_t)caidaClase];
+      const uint32_t ms = millis() - caidaAt;
+      r.outages++;
+      r.lastMs   = ms;
+      r.maxMs    = std::max(r.maxMs, ms);
+      r.totalMs += ms;
+      salud.reconnect(ms);
+      AWM_LOGI("🩹 Recuperado de caída %s en %lu ms (promedio %lu ms en %u)", nombreClase(caidaClase),
+               (unsigned long)ms, (unsigned long)(r.totalMs / r.outages), r.outages);
+      caidaAt = 0;
+    }
+    claseSeguidas     = 0;
+    esperaReintentoMs = reconnectBackoffMs;
+    backoff.reset();
+  }
+
+  // Durante /save el progreso lo informa provisionTask
+  if (provEstado != PROV_PROBANDO && connected != sseLastLink) {
+    sseLastLink = connected;
+    sseEstadoConexion(connected ? "connected" : "disconnected");
+  }
+  if (linkCb) linkCb(e);
 }
 
-bool AyresWiFiManager::isConnected() {
-  connected = (WiFi.status() == WL_CONNECTED);
-  return connected;
+// Espera hasta el próximo reintento según la clase del fallo (caída del
+// enlace o intento de reconexión fallido). Devuelve la clase efectiva; abrir
+// o no el portal lo decide la política (aplicarFallback/SMART_RETRIES).
+// claseSeguidas cuenta solo intentos fallidos: la caída abre la serie en 0,
+// así un mismo corte no suma dos veces (caída + primer reintento).
+// El resto de las esperas sale del backoff exponencial con jitter (backoff.next()):
+//   AUTH      → reintento lento, cada AUTH_REINTENTO_MS (reintentar rápido no cambia la clave)
+//   NO_AP     → avanza dos escalones por fallo (crece el doble de rápido)
+//   BEACON    → tras la caída, reintento sin espera; luego un escalón por fallo
+//   HANDSHAKE → un escalón; el segundo intento seguido se trata como AUTH
+AyresWiFiManager::DisconnectClass AyresWiFiManager::estrategiaCaida(DisconnectClass c, bool intento) {
+  if (c == DisconnectClass::NONE) c = DisconnectClass::OTHER;   // ventana agotada sin motivo
+  ultimoFalloWiFi = millis();
+  if (intento) claseSeguidas = (c == ultimaClase && claseSeguidas < 255) ? claseSeguidas + 1 : 1;
+  else         claseSeguidas = 0;
+  ultimaClase   = c;
+  if (c == DisconnectClass::HANDSHAKE && claseSeguidas >= 2) c = DisconnectClass::AUTH;
+
+  switch (c) {
+    case DisconnectClass::AUTH:
+      esperaReintentoMs = std::max<uint32_t>(reconnectBackoffMs, AUTH_REINTENTO_MS);
+      AWM_LOGW("🔑 \"%s\" rechazó la clave → reintento en %lu ms", ssid.c_str(),
+               (unsigned long)esperaReintentoMs);
+      return c;
+    case DisconnectClass::NO_AP:
+      backoff.next();
+      esperaReintentoMs = backoff.next();
+      break;
+    case DisconnectClass::BEACON:
+      esperaReintentoMs = (claseSeguidas == 0) ? 0 : backoff.next();
+      break;
+    default:
+      esperaReintentoMs = backoff.next();
+      break;
+  }
+  AWM_LOGI("🔁 Fallo %s (%u seguidos): próximo intento en %lu ms", nombreClase(c),
+           claseSeguidas, (unsigned long)esperaReintentoMs);
+  return c;
 }
 
-int AyresWiFiManager::getSignalStrength() {
-  return WiFi.RSSI();
+AyresWiFiManager::LinkState AyresWiFiManager::getLinkState() const { return linkEstado; }
+void AyresWiFiManager::onLinkChange(LinkCallback cb){ linkCb = cb; }
+uint8_t AyresWiFiManager::getLastDisconnectReason() const { return ultimoMotivo; }
+AyresWiFiManager::DisconnectClass AyresWiFiManager::getLastDisconnectClass() const {
+  return clasificarMotivo(ultimoMotivo);
+}
+AyresWiFiManager::RecoveryStats AyresWiFiManager::getRecoveryStats(DisconnectClass c) const {
+  return recStats[(uint8_t)c];
 }
 
-void AyresWiFiManager::reintentarConexionSiNecesario() {
-  if (!autoReconnect) return;
-  if (WiFi.status() == WL_CONNECTED){ connected = true; return; }
+// =====================================================
+//                     CONEXIÓN STA
+// =====================================================
+bool AyresWiFiManager::beginConnect() {
+  return tieneCredenciales() && iniciarConexion(CONN_USUARIO, CONNECT_TIMEOUT_MS);
+}
 
-  connected = false;
-  unsigned long ahora = millis();
+AyresWiFiManager::ConnectState AyresWiFiManager::getConnectState() const { return connState; }
+uint32_t AyresWiFiManager::getLastConnectMs() const { return lastConnectMs; }
+void AyresWiFiManager::onConnectResult(ConnectCallback cb){ connCb = cb; }
+
+// Candidatos del escaneo: redes guardadas presentes, mejor puntaje primero:
+//   prioridad·20 + (RSSI+100) + 15 si fue la última que funcionó − 5·fallos
+// (fallos = ventanas agotadas seguidas, tope 5). Sin escaneo entran todas
+// sin el término de señal. Ninguna presente → el intento falla ya, sin
+// gastar ventanas contra SSIDs que no están (equipo movido de sitio).
+void AyresWiFiManager::ordenarCandidatos(bool conEscaneo) {
+  connCands.clear();
+  for (size_t i = 0; i < redes.size(); i++) {
+    Candidato c{(uint8_t)i, 0, -100};
+    if (conEscaneo) {
+      auto e = std::find_if(scanResults.begin(), scanResults.end(),
+                            [&](const ScanEntry& x){ return redes[i].ssid == x.ssid; });
+      if (e == scanResults.end()) continue;
+      c.canal = e->channel;
+      c.rssi  = e->rssi;
+    }
+    connCands.push_back(c);
+  }
+  auto puntaje = [this](const Candidato& c) {
+    const Red& r = redes[c.red];
+    return r.prio * 20 + (c.rssi + 100) + (r.ssid == ultimaRed ? 15 : 0) -
+           std::min<int>(r.fallos, 5) * 5;
+  };
+  std::stable_sort(connCands.begin(), connCands.end(),
+                   [&](const Candidato& a, const Candidato& b){ return puntaje(a) > puntaje(b); });
+  if (!portalActive) {   // sin /scan que servir: liberar y dar el cache por vencido
+    std::vector<ScanEntry>().swap(scanResults);
+    scanHasResult = false;
+  }
 
-  // [CHANGED] Backoff configurable
-  if (ahora - ultimoIntentoWiFi < reconnectBackoffMs) return;
-  ultimoIntentoWiFi = ahora;
+  connCandIdx = 0;
+  if (connCands.empty()) {
+    AWM_LOGW("📡 Ninguna de las %u redes guardadas está a la vista", (unsigned)redes.size());
+    terminarConexion(false);
+    return;
+  }
+  AWM_LOGI("📡 %u de %u redes guardadas a la vista; primero \"%s\"", (unsigned)connCands.size(),
+           (unsigned)redes.size(), redes[connCands[0].red].ssid.c_str());
+  prepararCandidato();
+  connFase = FASE_BEGIN;
+}
 
-  if (!ssid.isEmpty() && !password.isEmpty()) {
-    AWM_LOGI("🔁 Intentando reconexión WiFi... (ventana=%lu ms, backoff=%lu ms)",
-             (unsigned long)reconnectAttemptMs, (unsigned long)reconnectBackoffMs);
+// Activa connCands[connCandIdx]: credenciales, pista, lease y ventana. La
+// ventana es adaptativa cuando begin() va dirigido (pista o canal del
+// escaneo): 2.5× la última asociación + 1.5 s, entre RED_VENTANA_MIN_MS y la
+// ventana del intento, +2 s con señal débil. Sin historial, la ventana completa.
+void AyresWiFiManager::prepararCandidato() {
+  const Candidato& c = connCands[connCandIdx];
+  seleccionarRed(c.red);
+  const Red& r = redes[c.red];
+
+  connConPista  = pistaValida && (!c.canal || c.canal == pistaCanal);
+  connConLease  = leaseOn && leaseValido && lease.ssid == ssid;
+  connVentanaMs = connTimeoutMs;
+  if ((connConPista || c.canal) && r.ms) {
+    uint32_t v = r.ms * 5 / 2 + 1500;
+    if (c.canal && c.rssi < -80) v += 2000;
+    connVentanaMs = std::min<uint32_t>(connTimeoutMs, std::max<uint32_t>(v, RED_VENTANA_MIN_MS));
+  }
+}
 
-    // [CHANGED] Si hay portal AWM o AP externo, mantener AP activo durante el intento
-    if (portalActive || externalApActive) WiFi.mode(WIFI_AP_STA);
-    else                                  WiFi.mode(WIFI_STA);
+// Ventana agotada: la red suma un fallo (baja en el ranking) y se pasa a la
+// siguiente presente; sin más candidatos el intento termina en fallo.
+void AyresWiFiManager::siguienteCandidato() {
+  Red& r = redes[connCands[connCandIdx].red];
+  if (r.fallos < 255) r.fallos++;
+  if (++connCandIdx < connCands.size()) {
+    AWM_LOGW("⏱️ \"%s\" sin conexión en %lu ms → siguiente red", r.ssid.c_str(),
+             (unsigned long)(millis() - connFaseAt));
+    WiFi.disconnect();
+    prepararCandidato();
+    connFase = FASE_BEGIN;
+    return;
+  }
+  AWM_LOGW("⏱️ No se pudo conectar (motivo %u).", (uint8_t)linkMotivo);
+  terminarConexion(false);
+}
 
-    WiFi.begin(ssid.c_str(), password.c_str());
-    uint32_t t0 = millis();
-    bool ok = false;
+// Arma un intento; connectTask() lo ejecuta por pasos desde update().
+// Primero la última red que funcionó (con su pista, sin escanear). Con una
+// sola red guardada es todo; con varias, si la pista no asocia se escanea una
+// vez y se prueban las presentes en orden (ordenarCandidatos).
+bool AyresWiFiManager::iniciarConexion(ConnOrigen origen, uint32_t timeoutMs) {
+  if (redes.empty()) return false;
+
+  if (leaseOn && !leaseCargado) cargarLease();
+
+  int primera = indiceRed(ultimaRed);
+  if (primera < 0) primera = redActual >= 0 ? redActual : 0;
+
+  connOrigen    = origen;
+  connTimeoutMs = timeoutMs;
+  connEscaneo   = (redes.size() == 1);   // una sola red: nada que elegir
+  connCands.assign(1, Candidato{(uint8_t)primera, 0, 0});
+  connCandIdx   = 0;
+  prepararCandidato();
+  connFase      = FASE_MODO;
+  connState     = ConnectState::CONNECTING;
+  connStart     = millis();
+  sseEstadoConexion("connecting");
+  return true;
+}
 
-    // [CHANGED] Ventana configurable
-    while (millis() - t0 < reconnectAttemptMs) {
-      if (WiFi.status() == WL_CONNECTED) { ok = true; break; }
-      delay(250);
-    }
-    if (ok) {
-      AWM_LOGI("🔌 Reconectado a WiFi.");
-      sincronizarHoraNTP();
-      connected = true;
-      failCount = 0; failWindowStart = 0;
-      return;
+// Llamado desde update(). Cada paso es una llamada corta al driver; se avanza
+// al siguiente en la misma vuelta solo si queda presupuesto (reconnectBudgetMs),
+// así ni el cambio de modo ni begin() se suman en una sola vuelta del loop.
+void AyresWiFiManager::connectTask() {
+  if (connState != ConnectState::CONNECTING) return;
+  const unsigned long t0 = millis();
+
+  while (connState == ConnectState::CONNECTING) {
+    switch (connFase) {
+      case FASE_MODO: {
+        // Con portal o AP externo arriba el intento va en AP+STA
+        const bool ap = portalActive || externalApActive;
+        if (WiFi.getMode() != (ap ? WIFI_AP_STA : WIFI_STA)) WiFi.mode(ap ? WIFI_AP_STA : WIFI_STA);
+        connFase = (connConPista || connEscaneo) ? FASE_BEGIN : FASE_ESCANEO;
+        break;
+      }
+      case FASE_ESCANEO:
+        if (!connEscaneo) {
+          WiFi.disconnect();   // cortar el paso con pista: el driver no escanea mientras asocia
+          connEscaneo    = true;
+          connScanPrevio = lastScanAt;
+          connFaseAt     = millis();
+          if (!iniciarEscaneo()) {
+            ordenarCandidatos(false);   // sin escaneo: todas, por prioridad e historial
+            break;
+          }
+          AWM_LOGD("📡 Escaneando para elegir entre %u redes guardadas", (unsigned)redes.size());
+        }
+        if (scanning) return;   // escaneoTask() lo recoge
+        ordenarCandidatos(scanHasResult && lastScanAt != connScanPrevio);
+        break;
+      case FASE_BEGIN:
+        // IP: lease cacheado como estática, o DHCP (deshacer una estática previa)
+        if (connConLease) {
+          WiFi.config(IPAddress(lease.ip), IPAddress(lease.gw), IPAddress(lease.mask),
+                      IPAddress(lease.dns1), IPAddress(lease.dns2));
+          leaseAplicado = true;
+        } else if (leaseAplicado) {
+          WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+          leaseAplicado = false;
+        }
+        connFaseAt = millis();
+        // begin() reinicia la asociación: no confundir el enlace anterior con este
+        linkEstado   = LinkState::DOWN;
+        linkMotivo   = 0;
+        linkSondeoAt = connFaseAt;
+        if (connConPista) {
+          WiFi.begin(ssid.c_str(), password.c_str(), pistaCanal, pistaBssid);
+          AWM_LOGI("Conectando a %s (BSSID/canal %u guardados)", ssid.c_str(), pistaCanal);
+        } else if (connCands[connCandIdx].canal) {
+          WiFi.begin(ssid.c_str(), password.c_str(), connCands[connCandIdx].canal);
+          AWM_LOGI("Conectando a %s (canal %u, %d dBm, ventana=%lu ms)", ssid.c_str(),
+                   connCands[connCandIdx].canal, connCands[connCandIdx].rssi,
+                   (unsigned long)connVentanaMs);
+        } else {
+          WiFi.begin(ssid.c_str(), password.c_str());
+          AWM_LOGI("Conectando a %s (ventana=%lu ms)", ssid.c_str(), (unsigned long)connVentanaMs);
+        }
+        connFase = FASE_ESPERA;
+        break;
+      case FASE_ESPERA: {
+        // Motivo del driver para este begin(); los que llegan enseguida pueden ser del anterior
+        const DisconnectClass fallo = (millis() - connFaseAt >= MOTIVO_GRACIA_MS)
+                                      ? clasificarMotivo(linkMotivo) : DisconnectClass::NONE;
+        if (enlaceConIp() && connConLease) {
+          // IP estática: confirmar que el gateway del lease existe en esta red
+          connFase  = FASE_GATEWAY;
+          gwCheckAt = millis();
+          gwArpAt   = 0;
+          break;
+        } else if (linkEstado == LinkState::GOT_IP) {
+          terminarConexion(true);
+        } else if (fallo == DisconnectClass::AUTH) {
+          // Clave rechazada: esperar la ventana no cambia nada
+          AWM_LOGW("🔑 \"%s\" rechazó la clave (motivo %u)", ssid.c_str(), (uint8_t)linkMotivo);
+          siguienteCandidato();
+        } else if (connConPista && (fallo == DisconnectClass::NO_AP ||
+                   millis() - connFaseAt >= std::min<unsigned long>(PISTA_VENTANA_MS, connVentanaMs))) {
+          // El AP cambió de canal o ya no está: la pista deja de valer (en RAM;
+          // el próximo éxito guarda la nueva). Con varias redes, escanear y
+          // elegir; si no, barrido completo (o el canal visto) con lo que queda
+          // de la ventana: la pista ya consumió parte.
+          connConPista = false;
+          pistaValida  = false;
+          redes[connCands[connCandIdx].red].canal = 0;
+          if (!connEscaneo) {
+            AWM_LOGD("📌 Pista sin respuesta → escaneo");
+            connFase = FASE_ESCANEO;
+          } else {
+            const uint32_t total = connCands[connCandIdx].canal ? connVentanaMs : connTimeoutMs;
+            const uint32_t usado = millis() - connFaseAt;
+            connVentanaMs = std::max<uint32_t>(total > usado ? total - usado : 0, RED_VENTANA_MIN_MS);
+            AWM_LOGD("📌 Pista sin respuesta → barrido completo (quedan %lu ms)",
+                     (unsigned long)connVentanaMs);
+            connFase = FASE_BEGIN;
+          }
+          break;
+        } else if (fallo == DisconnectClass::NO_AP || millis() - connFaseAt >= connVentanaMs) {
+          siguienteCandidato();
+        }
+        // Sin enlace todavía: la próxima lectura en la próxima vuelta
+        if (connState == ConnectState::CONNECTING) return;
+        break;
+      }
+      case FASE_GATEWAY: {
+        // Gateway visto y nadie más respondió por la IP durante LEASE_DAD_MS
+        const bool enviar = (gwArpAt == 0 || millis() - gwArpAt >= LEASE_ARP_EVERY_MS);
+        if (enviar) gwArpAt = millis();
+        const bool gwOk  = gatewayRespondeArp(lease.ip, lease.gw, enviar);
+        const bool enUso = ipPropiaEnUso();
+        if (gwOk && !enUso && millis() - gwCheckAt >= LEASE_DAD_MS) {
+          arpSondaTerminar();
+          terminarConexion(true);
+        } else if (enUso || millis() - gwCheckAt >= LEASE_GW_TIMEOUT_MS) {
+          arpSondaTerminar();
+          AWM_LOGW("📇 %s → DHCP", enUso ? "Otro equipo ya usa la IP del lease"
+                                         : "El gateway del lease no responde");
+          borrarLease();
+          connConLease = false;
+          WiFi.disconnect();
+          connFase = FASE_BEGIN;
+          break;
+        }
+        if (connState == ConnectState::CONNECTING) return;
+        break;
+      }
     }
-    AWM_LOGW("❌ Reconexión WiFi fallida.");
+    if (millis() - t0 >= reconnectBudgetMs) break;
+  }
+
+  const unsigned long used = millis() - t0;
+  if (used > reconnectBudgetMs) {
+    AWM_LOGD("⏱️ Paso de conexión: %lu ms (presupuesto %lu ms)",
+             (unsigned long)used, (unsigned long)reconnectBudgetMs);
+  }
+}
+
+void AyresWiFiManager::terminarConexion(bool ok) {
+  connState = ok ? ConnectState::CONNECTED : ConnectState::FAILED;
+  connected = ok;
+  sseLastLink = ok;
+  sseEstadoConexion(ok ? "connected" : "failed");
+
+  const unsigned long used = millis() - connStart;
+  if (ok) {
+    lastConnectMs = used;
+    AWM_LOGI("Conectado. IP: %s (%lu ms%s%s)", WiFi.localIP().toString().c_str(),
+             (unsigned long)used, connConPista ? ", BSSID guardado" : "",
+             connConLease ? ", lease cacheado" : ", DHCP");
+#if defined(ESP32)
+    WiFi.setSleep(false);
+#endif
+    recordarRed(millis() - connFaseAt);
+    if (!connConLease) capturarLease();
+  }
 
-    // SMART_RETRIES (sin cambios)
-    if (fallbackPolicy == FallbackPolicy::SMART_RETRIES) {
-      if (failWindowStart == 0 || (millis() - failWindowStart) > failWindowMs) {
-        failWindowStart = millis();
-        failCount = 0;
+  // NTP: configTime() no bloquea y nada espera la hora (ntpTask avisa)
+  switch (connOrigen) {
+    case CONN_RUN:
+      if (ok) {
+        AWM_LOGI("✅ Conexión WiFi exitosa.");
+        sincronizarHoraNTP();
+      } else {
+        estrategiaCaida(clasificarMotivo(linkMotivo));
+        aplicarFallback();
       }
-      failCount++;
-      AWM_LOGD("📉 SMART: fallos=%u/%u en %lu ms",
-               failCount, maxFailRetries, (unsigned long)(millis()-failWindowStart));
-      if (failCount >= maxFailRetries) {
-        AWM_LOGW("🚪 SMART: abriendo portal por fallos acumulados");
-        startPortal();
+      break;
+
+    case CONN_RECONEXION:
+      if (ok) {
+        AWM_LOGI("🔌 Reconectado a WiFi.");
+        sincronizarHoraNTP();
         failCount = 0; failWindowStart = 0;
+        break;
       }
-    }
+      AWM_LOGW("❌ Reconexión WiFi fallida.");
+      // Clave rechazada: lo que haría la política tras un arranque fallido
+      // (ON_FAIL abre el portal; NO_CREDENTIALS_ONLY no). SMART_RETRIES la cuenta abajo.
+      if (estrategiaCaida(clasificarMotivo(linkMotivo)) == DisconnectClass::AUTH &&
+          fallbackPolicy != FallbackPolicy::SMART_RETRIES) {
+        aplicarFallback();
+        break;
+      }
+
+      // SMART_RETRIES
+      if (fallbackPolicy == FallbackPolicy::SMART_RETRIES) {
+        if (failWindowStart == 0 || (millis() - failWindowStart) > failWindowMs) {
+          failWindowStart = millis();
+          failCount = 0;
+        }
+        failCount++;
+        AWM_LOGD("📉 SMART: fallos=%u/%u en %lu ms",
+                 failCount, maxFailRetries, (unsigned long)(millis()-failWindowStart));
+        if (failCount >= maxFailRetries) {
+          AWM_LOGW("🚪 SMART: abriendo portal por fallos acumulados");
+          startPortal();
+          failCount = 0; failWindowStart = 0;
+        }
+      }
+      break;
+
+    case CONN_USUARIO:
+      break;
+  }
+  if (connCb) connCb(ok);
+}
+
+// Wrapper bloqueante (compatibilidad): espera el resultado de beginConnect().
+bool AyresWiFiManager::connectToWiFi() {
+  if (!beginConnect()) return false;
+  while (connState == ConnectState::CONNECTING) {
+    connectTask();
+    escaneoTask();   // con varias redes, el intento puede esperar un escaneo
+    ledTask();
+    delay(10);
+  }
+  return connState == ConnectState::CONNECTED;
+}
+
+bool AyresWiFiManager::isConnected() {
+  connected = enlaceConIp();
+  return connected;
+}
+
+int AyresWiFiManager::getSignalStrength() {
+  return WiFi.RSSI();
+}
+
+// No bloquea: si toca (backoff) arma un intento de reconexión que update()
+// ejecuta por pasos; éxito/fallo y la cuenta SMART_RETRIES se aplican al terminar.
+void AyresWiFiManager::reintentarConexionSiNecesario() {
+  if (!autoReconnect) return;
+  if (provEstado == PROV_PROBANDO) return;   // /save está probando otra red
+  if (connState == ConnectState::CONNECTING) return;   // intento en curso
+  if (enlaceConIp()){ connected = true; return; }
+
+  connected = false;
+  unsigned long ahora = millis();
+
+  // Espera según la clase del último fallo (estrategiaCaida), contada desde
+  // ese fallo: la ventana del intento no se descuenta de la espera
+  if (ahora - ultimoFalloWiFi < esperaReintentoMs) return;
+
+  if (!redes.empty()) {
+    AWM_LOGI("🔁 Intentando reconexión WiFi... (ventana=%lu ms, espera=%lu ms)",
+             (unsigned long)reconnectAttemptMs, (unsigned long)esperaReintentoMs);
+    // [CHANGED] Si hay portal AWM o AP externo, el intento va en AP+STA (connectTask)
+    iniciarConexion(CONN_RECONEXION, reconnectAttemptMs);
   }
 }
 
@@ -689,12 +2208,14 @@ bool AyresWiFiManager::scanRedDetectada() {
   if (ahora - ultimoScan < SCAN_INTERVAL_MS) return false;
   ultimoScan = ahora;
 
-  if (WiFi.status() == WL_CONNECTED && !portalActive) return false;
+  if (enlaceConIp() && !portalActive) return false;
+  if (scanning) return false;   // no pisar el escaneo asíncrono del portal
+  if (connState == ConnectState::CONNECTING) return false;   // no interrumpir beginConnect()
 
   int n = WiFi.scanNetworks(/*async=*/false, /*show_hidden=*/false);
   bool encontrada = false;
-  for (int i = 0; i < n; ++i) {
-    if (WiFi.SSID(i) == ssid) { encontrada = true; break; }
+  for (int i = 0; i < n && !encontrada; ++i) {
+    encontrada = indiceRed(WiFi.SSID(i)) >= 0;   // cualquiera de las redes guardadas
   }
   WiFi.scanDelete();
   return encontrada;
@@ -702,28 +2223,164 @@ bool AyresWiFiManager::scanRedDetectada() {
 
 void AyresWiFiManager::forzarReconexion() {
   AWM_LOGI("🔄  Forzando reconexión…");
-  // [CHANGED] Respetar AP externo para no tumbarlo
-  if (portalActive || externalApActive) WiFi.mode(WIFI_AP_STA);
-  else                                  WiFi.mode(WIFI_STA);
-
-  WiFi.begin(ssid.c_str(), password.c_str());
-  ultimoIntentoWiFi = millis();
+  // Mismo camino que los reintentos: pista BSSID/canal y luego barrido completo.
+  // connectTask() respeta el AP externo (AP+STA) para no tumbarlo.
+  if (provEstado == PROV_PROBANDO) return;
+  connState = ConnectState::IDLE;
+  iniciarConexion(CONN_RECONEXION, reconnectAttemptMs);
 }
 
 // =====================================================
 //                     NTP / TIEMPO
 // =====================================================
+// configTime() arranca SNTP en segundo plano y nada espera la respuesta: el
+// aviso de sincronización del core (otra tarea en ESP32, settimeofday() en
+// ESP8266) levanta ntpAviso y ntpTask() lo entrega desde update().
+#if defined(ESP32)
+static std::atomic<bool> ntpAviso{false};
+#else
+static volatile bool ntpAviso = false;
+static bool ntpRestaurando = false;   // settimeofday() propio: no es SNTP
+#endif
+
+// Copia de la hora en memoria RTC (sobrevive a reinicios en caliente, no a
+// un corte de energía): epoch de la última escritura, que se hace cada
+// RTC_GUARDADO_MS; al arrancar, epoch + millis() da la hora con un error de
+// ese intervalo más lo que tardó el reinicio.
+struct AwmHoraRtc {
+  uint32_t magia;
+  uint32_t epoch;   // hora al guardar
+  uint32_t sntp;    // epoch de la última respuesta SNTP
+  uint32_t control;
+};
+static constexpr uint32_t HORA_RTC_MAGIA = 0x41574D54;   // "AWMT"
+static uint32_t controlHora(const AwmHoraRtc& h) {
+  return (h.magia ^ h.epoch * 2654435761u ^ h.sntp) + 0x9E3779B9u;
+}
+#if AWM_RTC_TIME && defined(ESP32)
+RTC_NOINIT_ATTR static AwmHoraRtc horaRtc;
+#endif
+
+// SNTP (lwIP) se queda con los punteros de configTime() y los lee desde su
+// tarea: con SNTP en marcha se lo detiene antes de reescribir los buffers.
+void AyresWiFiManager::setNtpServers(const char* s1, const char* s2, const char* s3) {
+  const char* nuevos[3] = { s1 ? s1 : "", s2 ? s2 : "", s3 ? s3 : "" };
+  for (const char* s : nuevos) {
+    if (strlen(s) > NTP_HOST_MAX) {
+      AWM_LOGW("🕒 Servidor NTP \"%s\" demasiado largo (máx. %u): se conserva la lista", s,
+               (unsigned)NTP_HOST_MAX);
+      return;
+    }
+  }
+#if defined(ESP32)
+  if (ntpIniciado) {
+  #if ESP_IDF_VERSION_MAJOR >= 5
+    esp_sntp_stop();
+  #else
+    sntp_stop();
+  #endif
+  }
+#endif
+  for (int i = 0; i < 3; i++) strlcpy(ntpServidores[i], nuevos[i], sizeof(ntpServidores[i]));
+  if (ntpIniciado) {                 // ya corría: reconfigurar con la lista nueva
+    ntpIniciado = ntpSincronizado = false;
+    if (connected) sincronizarHoraNTP();
+  }
+}
+
+void AyresWiFiManager::onTimeSync(TimeSyncCallback cb){ ntpCb = cb; }
+bool AyresWiFiManager::isTimeSynced() const { return ntpSincronizado; }
+
+// Con la primera conexión (o mientras SNTP no haya respondido). Una vez
+// sincronizado, SNTP resincroniza solo y no hace falta volver a llamarlo.
 void AyresWiFiManager::sincronizarHoraNTP() {
-  configTime(0, 0, "pool.ntp.org", "time.nist.gov");
-  for (int j = 0; j < 20; j++) {
+  if (ntpIniciado && ntpSincronizado) return;
+  if (!ntpServidores[0][0]) return;
+
+#if defined(ESP32)
+  sntp_set_time_sync_notification_cb([](struct timeval*) { ntpAviso = true; });
+#else
+  settimeofday_cb([]() { if (!ntpRestaurando) ntpAviso = true; });
+#endif
+  auto srv = [this](int i) -> const char* { return ntpServidores[i][0] ? ntpServidores[i] : nullptr; };
+  configTime(0, 0, srv(0), srv(1), srv(2));
+  ntpIniciado   = true;
+  ntpAvisoLento = false;
+  ntpDesde      = millis();
+  AWM_LOGD("🕒 SNTP en segundo plano (%s)", ntpServidores[0]);
+}
+
+// Llamado desde update(): entrega la sincronización y refresca la copia en RTC.
+void AyresWiFiManager::ntpTask() {
+  if (ntpAviso) {
+    ntpAviso = false;
     time_t now = time(nullptr);
-    if (now > 100000) {
-      AWM_LOGI("🕒 Hora sincronizada: %s", ctime(&now));
-      return;
+    if (!ntpSincronizado) {
+      AWM_LOGI("🕒 Hora sincronizada en %lu ms: %s", (unsigned long)(millis() - ntpDesde), ctime(&now));
     }
-    delay(200);
+    ntpSincronizado = true;
+    guardarHoraRtc();
+    if (ntpCb) ntpCb(now);
+  } else if (ntpIniciado && !ntpSincronizado && !ntpAvisoLento && millis() - ntpDesde >= NTP_AVISO_MS) {
+    ntpAvisoLento = true;
+    AWM_LOGI("🕒 NTP aún sin respuesta; SNTP sigue en segundo plano.");
   }
-  AWM_LOGW("⚠️ NTP no respondió. Continuando sin sincronizar.");
+#if AWM_RTC_TIME
+  if (millis() - rtcGuardadoAt >= RTC_GUARDADO_MS) guardarHoraRtc();
+#endif
+}
+
+void AyresWiFiManager::guardarHoraRtc() {
+#if AWM_RTC_TIME
+  rtcGuardadoAt = millis();
+  const time_t now = time(nullptr);
+  if (now <= 100000) return;
+
+  AwmHoraRtc h;
+  h.magia = HORA_RTC_MAGIA;
+  h.epoch = (uint32_t)now;
+  h.sntp  = ntpSincronizado ? (uint32_t)now : 0;
+  #if defined(ESP32)
+    if (!ntpSincronizado && horaRtc.magia == HORA_RTC_MAGIA) h.sntp = horaRtc.sntp;
+    h.control = controlHora(h);
+    horaRtc   = h;
+  #else
+    if (!ntpSincronizado) {
+      AwmHoraRtc prev;
+      if (ESP.rtcUserMemoryRead(AWM_RTC_BLOCK, (uint32_t*)&prev, sizeof(prev)) &&
+          prev.magia == HORA_RTC_MAGIA) h.sntp = prev.sntp;
+    }
+    h.control = controlHora(h);
+    ESP.rtcUserMemoryWrite(AWM_RTC_BLOCK, (uint32_t*)&h, sizeof(h));
+  #endif
+#endif
+}
+
+// En begin(): si el reloj del sistema no sobrevivió al reinicio, lo repone
+// desde la copia en RTC. isTimeSynced() sigue en false hasta que responda SNTP.
+void AyresWiFiManager::restaurarHoraRtc() {
+#if AWM_RTC_TIME
+  if (time(nullptr) > 100000) return;   // ESP32: la hora del sistema ya se conservó
+
+  AwmHoraRtc h;
+  #if defined(ESP32)
+    h = horaRtc;
+  #else
+    if (!ESP.rtcUserMemoryRead(AWM_RTC_BLOCK, (uint32_t*)&h, sizeof(h))) return;
+  #endif
+  if (h.magia != HORA_RTC_MAGIA || h.control != controlHora(h)) return;   // arranque en frío
+
+  struct timeval tv = { (time_t)(h.epoch + millis() / 1000), 0 };
+  #if defined(ESP8266)
+    ntpRestaurando = true;
+  #endif
+  settimeofday(&tv, nullptr);
+  #if defined(ESP8266)
+    ntpRestaurando = false;
+  #endif
+  AWM_LOGI("🕒 Hora repuesta desde RTC (SNTP de hace %lu s)",
+           h.sntp ? (unsigned long)(h.epoch - h.sntp) : 0UL);
+#endif
 }
 
 uint64_t AyresWiFiManager::getTimestamp() {
@@ -734,19 +2391,226 @@ uint64_t AyresWiFiManager::getTimestamp() {
 // =====================================================
 //                  INTERNET CHECK
 // =====================================================
+// Una sola sonda para toda la librería (estado estático, como arpSonda)
+static AwmProbe sondaNet;
+
 bool AyresWiFiManager::hayInternet() {
-  if (WiFi.status() != WL_CONNECTED) return false;
-  WiFiClient client;
-  HTTPClient http;
-  http.begin(client, "http://clients3.google.com/generate_204");
-#if defined(ESP32)
-  http.setConnectTimeout(3000);
-#else
-  http.setTimeout(3000);
-#endif
-  int httpCode = http.GET();
-  http.end();
-  return (httpCode == 204);
+  if (linkEstado != LinkState::GOT_IP) return false;
+  if (!netValido || millis() - netAt >= netTtlMs) netPedido = true;   // la lanza update()
+  return netOk;
+}
+
+void AyresWiFiManager::setInternetCheck(uint32_t ttlMs, uint32_t intervalMs) {
+  netTtlMs = ttlMs;
+  netIntervaloMs = intervalMs;
+}
+
+bool AyresWiFiManager::addInternetProbe(const char* url, uint16_t expectCode) {
+  static const struct { const char* esquema; AwmProbe::Mode modo; long puerto; } ESQUEMAS[] = {
+    { "http://", AwmProbe::HTTP, 80 }, { "tcp://", AwmProbe::TCP, 0 },
+    { "dns://",  AwmProbe::DNS,  0 },  { "ping://", AwmProbe::PING, 0 },
+  };
+  if (!url) return false;
+  int e = -1;
+  for (int i = 0; i < 4; i++) {
+    if (strncmp(url, ESQUEMAS[i].esquema, strlen(ESQUEMAS[i].esquema)) == 0) { e = i; break; }
+  }
+  if (e < 0) {
+    AWM_LOGW("🌐 Sonda \"%s\" ignorada: esquema http://, tcp://, dns:// o ping://", url);
+    return false;
+  }
+  const AwmProbe::Mode modo = ESQUEMAS[e].modo;
+  String resto(url + strlen(ESQUEMAS[e].esquema));
+  const int barra = resto.indexOf('/');
+  String host = (barra < 0) ? resto : resto.substring(0, barra);
+  String ruta = (barra < 0) ? String("/") : resto.substring(barra);
+  long puerto = ESQUEMAS[e].puerto;
+  const int dp = host.indexOf(':');
+  if (dp >= 0) {
+    puerto = host.substring(dp + 1).toInt();
+    host = host.substring(0, dp);
+  }
+  const bool conPuerto = (modo == AwmProbe::HTTP || modo == AwmProbe::TCP);
+  if (host.length() == 0 || host.length() > AwmProbe::HOST_MAX ||
+      ruta.length() > AwmProbe::RUTA_MAX || (conPuerto && (puerto <= 0 || puerto > 65535)) ||
+      netSondas.size() >= NET_MAX_SONDAS) {
+    AWM_LOGW("🌐 Sonda \"%s\" inválida o lista llena", url);
+    return false;
+  }
+  netSondas.push_back({ host, ruta, (uint16_t)(conPuerto ? puerto : 0), expectCode, (uint8_t)modo, {} });
+  return true;
+}
+
+void AyresWiFiManager::clearInternetProbes() {
+  if (netEnCurso) { sondaNet.cancel(); netEnCurso = false; }
+  netSondas.clear();
+  netPrimera = 0;
+}
+
+void AyresWiFiManager::onInternetChange(InternetCallback cb) { netCb = cb; }
+
+uint32_t AyresWiFiManager::getInternetCheckAgeMs() const {
+  return netValido ? (uint32_t)(millis() - netAt) : UINT32_MAX;
+}
+
+uint32_t AyresWiFiManager::getInternetRttMs() const { return netRttMs; }
+
+void AyresWiFiManager::lanzarSondaNet() {
+  const SondaNet& s = netSondas[(netPrimera + netIdx) % netSondas.size()];
+  // "gateway" se resuelve al lanzar: el del lease actual
+  const String host = (s.host == "gateway") ? WiFi.gatewayIP().toString() : s.host;
+  netEnCurso = sondaNet.start((AwmProbe::Mode)s.modo, host.c_str(), s.puerto,
+                              s.ruta.c_str(), NET_TIMEOUT_MS);
+  if (!netEnCurso) netPedido = true;   // reintentar la ronda en la próxima vuelta
+}
+
+static const char* nombreEstadoNet(AyresWiFiManager::InternetState e) {
+  using E = AyresWiFiManager::InternetState;
+  switch (e) {
+    case E::LINK_DOWN:           return "link_down";
+    case E::LINK_UP_NO_DNS:      return "no_dns";
+    case E::LINK_UP_NO_INTERNET: return "no_internet";
+    case E::CAPTIVE_UPSTREAM:    return "captive";
+    case E::INTERNET_OK:         return "ok";
+    default:                     return "unknown";
+  }
+}
+
+AyresWiFiManager::InternetState AyresWiFiManager::getInternetState() const { return netEstado; }
+
+uint8_t AyresWiFiManager::getInternetProbeCount() const { return (uint8_t)netSondas.size(); }
+
+bool AyresWiFiManager::getInternetProbeStats(uint8_t index, ProbeStats& out) const {
+  if (index >= netSondas.size()) return false;
+  out = netSondas[index].st;
+  return true;
+}
+
+// Cierra la ronda (o la invalida si e es LINK_DOWN / UNKNOWN)
+void AyresWiFiManager::veredictoNet(InternetState e) {
+  const bool ok = (e == InternetState::INTERNET_OK);
+  const bool cambio = (e != netEstado);
+  const bool cambioOk = (ok != netOk);
+  netEstado = e;
+  netOk = ok;
+  netValido = (e != InternetState::LINK_DOWN && e != InternetState::UNKNOWN);
+  netAt = millis();
+  if (cambio && netValido) {
+    if (e == InternetState::CAPTIVE_UPSTREAM) {
+      AWM_LOGW("🌐 Portal cautivo aguas arriba (HTTP %d): sin Internet real", netRondaCodigo);
+    } else {
+      AWM_LOGI("🌐 Internet: %s", nombreEstadoNet(e));
+    }
+  }
+  if (cambioOk && netCb) netCb(ok);
+}
+
+void AyresWiFiManager::internetTask() {
+  if (linkEstado != LinkState::GOT_IP) {
+    // Sin IP no hay Internet: el veredicto cae ya y se rehace con la próxima IP
+    if (netEnCurso) { sondaNet.cancel(); netEnCurso = false; }
+    netPedido = false;
+    if (netEstado != InternetState::LINK_DOWN) veredictoNet(InternetState::LINK_DOWN);
+    return;
+  }
+  if (netEstado == InternetState::LINK_DOWN) veredictoNet(InternetState::UNKNOWN);
+
+  if (netEnCurso) {
+    if (!sondaNet.poll()) return;
+    netEnCurso = false;
+    const uint8_t i = (netPrimera + netIdx) % netSondas.size();
+    SondaNet& s = netSondas[i];
+    const bool completo = sondaNet.result() == AwmProbe::OK;
+    const int  codigo = sondaNet.httpCode();
+    const bool ok = completo && (s.modo != AwmProbe::HTTP || codigo == s.espera);
+    // Solo prueba Internet una ida y vuelta fuera de la LAN: un echo (gateway)
+    // o un DNS del cache de lwIP son evidencia para LINK_UP_*, nunca INTERNET_OK
+    const bool sinConsulta = (s.modo == AwmProbe::DNS && sondaNet.cached());
+    const bool internet = ok && s.modo != AwmProbe::PING && !sinConsulta;
+    AWM_LOGD("🌐 %s://%s → %s %d (rtt %lu ms, total %lu ms, heap %lu B)",
+             AwmProbe::nombre((AwmProbe::Mode)s.modo), s.host.c_str(),
+             AwmProbe::nombre(sondaNet.result()), codigo,
+             (unsigned long)sondaNet.rttMs(), (unsigned long)sondaNet.totalMs(),
+             (unsigned long)sondaNet.heapBytes());
+
+    ProbeStats& st = s.st;
+    if (ok) { if (st.ok < UINT16_MAX) st.ok++; }
+    else if (st.fails < UINT16_MAX) st.fails++;
+    st.lastCode = (int16_t)codigo;
+    if (completo && !sinConsulta) {
+      const uint32_t rtt = sondaNet.rttMs();
+      st.lastMs = rtt;
+      if (!st.samples || rtt < st.minMs) st.minMs = rtt;
+      if (rtt > st.maxMs) st.maxMs = rtt;
+      if (st.samples < UINT16_MAX) { st.samples++; st.totalMs += rtt; }
+    }
+
+    if (s.modo != AwmProbe::PING && !sinConsulta) salud.probe(internet, sondaNet.rttMs());
+    // Solo un nombre pasa por el resolver: una IP literal o "gateway" no
+    IPAddress literal;
+    const bool usaDns = s.host != "gateway" && !literal.fromString(s.host);
+    if (usaDns) netRondaUsaDns = true;
+    if (usaDns && sondaNet.resolved()) netRondaDns = true;   // del cache también vale
+    // Portal: un 2xx distinto del esperado (página de login en vez del 204) o
+    // una redirección. 4xx/5xx es un destino que falla, no un portal.
+    if (completo && !ok && s.modo == AwmProbe::HTTP && codigo >= 200 && codigo < 400) {
+      netRondaCodigo = (int16_t)codigo;
+    }
+
+    if (internet) { netPrimera = i; netRttMs = sondaNet.rttMs(); veredictoNet(InternetState::INTERNET_OK); return; }
+    if (++netIdx < netSondas.size()) { lanzarSondaNet(); return; }
+    // Ninguno dio OK: la mejor evidencia de la ronda decide la clase. Sin
+    // destinos por nombre el DNS no se probó: no puede ser LINK_UP_NO_DNS.
+    veredictoNet(netRondaCodigo                  ? InternetState::CAPTIVE_UPSTREAM
+               : netRondaDns || !netRondaUsaDns  ? InternetState::LINK_UP_NO_INTERNET
+                                                 : InternetState::LINK_UP_NO_DNS);
+    return;
+  }
+
+  const bool periodica = netIntervaloMs && (!netValido || millis() - netAt >= netIntervaloMs);
+  if (!netPedido && !periodica) return;
+  netPedido = false;
+  if (netSondas.empty()) return;
+  netIdx = 0;
+  netRondaDns = false;
+  netRondaUsaDns = false;
+  netRondaCodigo = 0;
+  lanzarSondaNet();
+}
+
+// =====================================================
+//                  SALUD DEL ENLACE
+// =====================================================
+void AyresWiFiManager::setHealthMonitor(bool enabled, uint32_t sampleMs) {
+  saludOn = enabled;
+  saludPeriodoMs = sampleMs ? sampleMs : 1000;
+}
+
+uint8_t AyresWiFiManager::getLinkQuality() const { return salud.quality(); }
+
+AyresWiFiManager::HealthReport AyresWiFiManager::getHealthReport() const { return salud.report(); }
+
+uint8_t AyresWiFiManager::getHealthSamples(HealthSample* out, uint8_t max) const {
+  return salud.copy(out, max);
+}
+
+// Una muestra por período: WiFi.RSSI() se lee acá y en ningún otro lado del
+// loop; caídas, reconexiones y sondas ya las sumaron linkTask/internetTask.
+void AyresWiFiManager::saludTask() {
+  if (!saludOn || millis() - saludAt < saludPeriodoMs) return;
+  saludAt = millis();
+
+  uint8_t flags = 0;
+  int8_t rssi = 0;
+  if (linkEstado == LinkState::GOT_IP) {
+    flags |= AwmHealth::F_LINK;
+    rssi = (int8_t)WiFi.RSSI();
+    if (netEstado == InternetState::INTERNET_OK)           flags |= AwmHealth::F_NET_OK;
+    else if (netEstado == InternetState::CAPTIVE_UPSTREAM) flags |= AwmHealth::F_NET_MAL | AwmHealth::F_CAPTIVE;
+    else if (netEstado != InternetState::UNKNOWN)          flags |= AwmHealth::F_NET_MAL;
+  }
+  salud.sample(saludAt, rssi, flags);
+  AWM_LOGV("🩺 Salud: calidad %u, RSSI %d (EWMA %d)", salud.quality(), rssi, salud.rssiAvg());
 }
 
 // =====================================================
@@ -773,7 +2637,7 @@ void AyresWiFiManager::ledAutoUpdate(){
     want = LedPattern::BLINK_FAST;
   } else if (portalActive) {
     want = LedPattern::BLINK_SLOW;
-  } else if (WiFi.status() == WL_CONNECTED) {
+  } else if (linkEstado == LinkState::GOT_IP) {
     want = LedPattern::ON;
   } else {
     want = LedPattern::OFF;
@@ -831,9 +2695,13 @@ void AyresWiFiManager::ledTask(){
 // =====================================================
 //                  RECONNECT DRIVER
 // =====================================================
+// true: update() reconecta solo, con backoff (estrategiaCaida), mientras no
+// haya portal abierto. false: nadie reconecta; queda en manos del sketch
+// (forzarReconexion()). El auto-reconnect del driver queda apagado en ambos
+// casos: reasocia sin espera ni jitter y pelearía con el backoff.
 void AyresWiFiManager::setAutoReconnect(bool habilitado) {
   autoReconnect = habilitado;
-  WiFi.setAutoReconnect(habilitado);
+  WiFi.setAutoReconnect(false);
 }
 
 // =====================================================
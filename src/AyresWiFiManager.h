@@ -10,17 +10,23 @@
  *
  *  @brief  Professional Wi-Fi manager for ESP32/ESP8266 featuring:
  *          • Captive portal (AP + DNS catch-all) for provisioning
- *          • Credentials stored in LittleFS (/wifi.json)
+ *          • Credentials stored in LittleFS (/wifi.json), up to AWM_MAX_NETWORKS
+ *            networks ranked by scan RSSI, priority and history
  *          • JSON scan endpoint (/scan or /scan.json)
  *          • Fallback policies + auto-reconnect
  *          • Provisioning button (short/long press actions)
  *          • Status LED patterns
  *          • Optional NTP sync and Internet reachability check (generate_204)
  *
- *  Key HTTP routes (served from LittleFS):
- *    - GET  /             → index.html
- *    - POST /save         → store SSID/password and restart
- *    - GET  /scan(.json)  → Wi-Fi list [{ssid,rssi,secure}]
+ *  Key HTTP routes (served from LittleFS, or flash with AWM_EMBED_PORTAL=1):
+ *    - GET  /             → index.html (index.html.gz if the client accepts gzip)
+ *    - POST /save         → test SSID/password live (AP+STA); persisted and applied
+ *                           without restart only if the STA gets an IP
+ *    - GET  /status       → progress of the last /save {state,ssid,ip,elapsed_ms,reason}
+ *    - GET  /events       → Server-Sent Events: scan results, link state, portal countdown
+ *    - GET  /scan(.json)  → Wi-Fi list [{ssid,rssi,channel,bssids,secure}], one per
+ *                           SSID, strongest first; ?limit=N&min_rssi=-80 (cached,
+ *                           setScanCacheMs; 202 + retry_ms while the first scan runs)
  *    - GET  /erase        → wipe stored credentials (respects whitelist)
  *
  *  Fallback policies:
@@ -55,7 +61,7 @@
  *        wifi.setWebClientCheck(true);    // reset timeout on HTTP requests
  *        // wifi.setCaptivePortal(false); // disable DNS redirection if needed
  *        wifi.begin();
- *        wifi.run();                      // try STA or fallback to portal
+ *        wifi.run();                      // start STA (non-blocking) or fallback to portal
  *      }
  *      void loop() { wifi.update(); }
  *    @endcode
@@ -89,6 +95,51 @@
 #include <DNSServer.h>
 #include <vector>
 #include <initializer_list>
+#include <functional>
+#include <time.h>
+#if defined(ESP32)
+  #include <atomic>
+#endif
+#include "AWM_Pmk.h"
+#include "AWM_Backoff.h"
+#include "AWM_Health.h"
+#include "AWM_Asset.h"
+
+class AwmJsonWriter;
+
+// Máximo de SSIDs (ya deduplicados) que guarda el cache de /scan: memoria
+// acotada sin importar cuántos BSSID reporte la radio; se quedan los más fuertes.
+#ifndef AWM_SCAN_MAX_RESULTS
+  #define AWM_SCAN_MAX_RESULTS 40
+#endif
+
+// Máximo de suscriptores simultáneos a /events (Server-Sent Events).
+#ifndef AWM_SSE_MAX_CLIENTS
+  #define AWM_SSE_MAX_CLIENTS 4
+#endif
+
+// Redes guardadas en /wifi.json. Con más de una, la conexión escanea una vez
+// y prueba las presentes ordenadas por señal, prioridad e historial.
+#ifndef AWM_MAX_NETWORKS
+  #define AWM_MAX_NETWORKS 5
+#endif
+
+// 1 = conservar la hora en memoria RTC: tras un reinicio en caliente
+// getTimestamp() es usable antes de que responda SNTP.
+#ifndef AWM_RTC_TIME
+  #define AWM_RTC_TIME 1
+#endif
+// ESP8266: primer bloque (4 bytes) de la memoria RTC de usuario que ocupa la
+// hora (4 bloques). Alto por defecto: los primeros quedan para la app/OTA.
+#ifndef AWM_RTC_BLOCK
+  #define AWM_RTC_BLOCK 120
+#endif
+
+// 1 = servir index/success/error desde arrays PROGMEM generados por
+// tools/embed_assets.py (AWM_PortalAssets.h), sin tocar LittleFS en el portal.
+#ifndef AWM_EMBED_PORTAL
+  #define AWM_EMBED_PORTAL 0
+#endif
 
 /**
  * @class AyresWiFiManager
@@ -112,6 +163,69 @@ public:
         NEVER
     };
 
+    // ---------- métricas de /scan (single-flight) ----------
+    struct ScanStats {
+        uint32_t requests  = 0;   // hits a /scan y /scan.json
+        uint32_t scans     = 0;   // escaneos de radio realmente lanzados
+        uint32_t fromCache = 0;   // respondidos con un resultado fresco
+        uint32_t joined    = 0;   // llegaron con un escaneo en curso y se unieron a él
+    };
+
+    // ---------- conexión STA asíncrona ----------
+    enum class ConnectState : uint8_t { IDLE, CONNECTING, CONNECTED, FAILED };
+    typedef std::function<void(bool ok)> ConnectCallback;
+
+    // ---------- estado del enlace STA (eventos del core) ----------
+    enum class LinkState : uint8_t { DOWN, ASSOCIATED, GOT_IP };
+    typedef std::function<void(LinkState estado)> LinkCallback;
+
+    // ---------- hora (SNTP) ----------
+    typedef std::function<void(time_t epoch)> TimeSyncCallback;
+
+    // ---------- Internet (sonda cacheada) ----------
+    typedef std::function<void(bool online)> InternetCallback;
+    // Clasificación del último chequeo (la ronda completa, no una sola sonda)
+    enum class InternetState : uint8_t {
+        UNKNOWN,               // con IP, todavía sin veredicto
+        LINK_DOWN,             // sin IP
+        LINK_UP_NO_DNS,        // IP pero ningún destino por nombre resolvió
+        LINK_UP_NO_INTERNET,   // resuelve (o no hubo nombres) pero nada contesta bien (timeout / rechazo / 4xx / 5xx)
+        CAPTIVE_UPSTREAM,      // un GET devolvió otro 2xx o un 3xx (200, 302…): portal / walled garden
+        INTERNET_OK
+    };
+    // Por destino (en el orden en que se agregaron)
+    struct ProbeStats {
+        uint16_t ok       = 0;    // sondas que dieron el resultado esperado (dns del cache también)
+        uint16_t fails    = 0;
+        uint32_t lastMs   = 0;    // rtt de la última sonda que completó (aunque el código no fuera el esperado; sin dns del cache)
+        uint32_t minMs    = 0;
+        uint32_t maxMs    = 0;
+        uint32_t totalMs  = 0;    // promedio = totalMs / (sondas que completaron)
+        uint16_t samples  = 0;    // sondas que completaron (base del promedio)
+        int16_t  lastCode = 0;    // estado HTTP de la última respuesta (0 = ninguna)
+    };
+
+    // ---------- motivo de desconexión (elige la estrategia de reintento) ----------
+    enum class DisconnectClass : uint8_t {
+        NONE,        // sin caída, o desconexión pedida por nosotros
+        AUTH,        // clave rechazada → reintento lento; portal según la política
+        NO_AP,       // AP no encontrado → espera creciente rápida
+        BEACON,      // beacons perdidos (transitorio) → reintento inmediato
+        HANDSHAKE,   // 4-way / group key handshake vencido (2 intentos seguidos = AUTH)
+        OTHER
+    };
+    // Tiempo de recuperación (caída → IP de nuevo) por clase de la caída
+    struct RecoveryStats {
+        uint16_t outages = 0;     // caídas recuperadas
+        uint32_t lastMs  = 0;
+        uint32_t maxMs   = 0;
+        uint32_t totalMs = 0;     // promedio = totalMs / outages
+    };
+
+    // ---------- monitor de salud (AWM_Health.h) ----------
+    typedef AwmHealth::Sample HealthSample;
+    typedef AwmHealth::Report HealthReport;
+
     // ---------- patrones del LED ----------
     enum class LedPattern : uint8_t {
         OFF, ON, BLINK_SLOW, BLINK_FAST, BLINK_DOUBLE, BLINK_TRIPLE
@@ -147,9 +261,9 @@ public:
     bool isConnected();
     int  getSignalStrength();
     uint64_t getTimestamp();
-    bool connectToWiFi();
+    bool connectToWiFi();   // bloqueante (wrapper de beginConnect)
     void reintentarConexionSiNecesario();
-    bool hayInternet();
+    bool hayInternet();        // veredicto cacheado, O(1) (ver "Chequeo de Internet")
     bool tieneCredenciales() const;
 
     // ---------- utilidades extra ----------
@@ -166,11 +280,124 @@ public:
     void setProtectedJsons(std::initializer_list<const char*> names);
 
     // ==== NUEVO: control de reconexión y AP externo ====
-    void setReconnectBackoffMs(uint32_t ms);   // [NEW]
+    void setReconnectBackoffMs(uint32_t ms);   // [NEW] base del backoff (conserva el resto)
+    // Espera entre reintentos: min(cap, base·mult^n) con jitter sembrado por la
+    // MAC (cada equipo reintenta en otro momento tras la caída del router).
+    // jitterPct = fracción de la espera que se sortea (0 = fija, 100 = 0..d).
+    void setReconnectBackoffPolicy(uint32_t baseMs, float multiplier = 2.0f,
+                                   uint32_t capMs = 300000, uint8_t jitterPct = 50);
     void setReconnectAttemptMs(uint32_t ms);   // [NEW]
+    // Tope (ms) que la conexión/reconexión puede ocupar dentro de un update():
+    // los pasos (modo, begin) se reparten entre vueltas del loop.
+    void setReconnectBudgetMs(uint32_t ms);
     void setExternalApActive(bool active);     // [NEW]
     bool isExternalApActive() const;           // [NEW]
 
+    // ==== Escaneo ====
+    // TTL del cache de /scan: dentro de esta ventana se responde desde RAM sin
+    // volver a escanear. 0 = cada request lanza un escaneo nuevo salvo que uno
+    // acabe de terminar (SCAN_JOIN_MS), que se comparte entre los que esperaban.
+    void setScanCacheMs(uint32_t ms);
+    // Contadores requests vs. escaneos reales (para verificar el coalescing)
+    ScanStats getScanStats() const;
+
+    // ==== Conexión STA no bloqueante ====
+    // beginConnect() lanza WiFi.begin() con las credenciales guardadas y vuelve
+    // enseguida (false si no hay credenciales); update() sigue el intento (con
+    // varias redes, escaneo y candidatos en orden) y al terminar invoca el callback.
+    bool beginConnect();
+    ConnectState getConnectState() const;
+    void onConnectResult(ConnectCallback cb);
+    // ms desde el inicio del último intento hasta IP usable (comparar DHCP vs lease)
+    uint32_t getLastConnectMs() const;
+
+    // ==== Estado del enlace ====
+    // Lo mantienen los eventos Wi-Fi del core (WiFi.onEvent / onStationMode*),
+    // no un WiFi.status() por vuelta. El callback se invoca desde update() en
+    // cada cambio (si hubo varios entre dos vueltas, con el último estado).
+    LinkState getLinkState() const;
+    void onLinkChange(LinkCallback cb);
+    // Último motivo de desconexión informado por el driver (código crudo y clase)
+    uint8_t getLastDisconnectReason() const;
+    DisconnectClass getLastDisconnectClass() const;
+    RecoveryStats getRecoveryStats(DisconnectClass c) const;
+
+    // ==== Hora (SNTP) ====
+    // SNTP arranca con la primera conexión y corre en segundo plano: ni run()
+    // ni las reconexiones esperan la hora. El callback se invoca desde update()
+    // en cada sincronización. Hasta 3 servidores (por defecto pool.ntp.org y
+    // time.nist.gov); se copian, no hace falta mantenerlos vivos.
+    void setNtpServers(const char* s1, const char* s2 = nullptr, const char* s3 = nullptr);
+    void onTimeSync(TimeSyncCallback cb);
+    // true si SNTP respondió en este arranque (antes, getTimestamp() puede venir de la copia en RTC)
+    bool isTimeSynced() const;
+
+    // ==== Chequeo de Internet ====
+    // hayInternet() nunca bloquea: devuelve el último veredicto y, si tiene
+    // más de ttlMs, pide una sonda nueva que update() avanza en segundo plano
+    // (DNS/TCP/HTTP por callbacks de lwIP, AWM_Probe.h). Con intervalMs > 0
+    // además se sondea cada intervalMs mientras haya IP. Sin IP → false ya.
+    // Hasta el primer veredicto con la IP actual (getInternetState() ==
+    // UNKNOWN) también da false: la primera llamada solo lanza la sonda.
+    // Para esperarlo, onInternetChange() o getInternetCheckAgeMs() != UINT32_MAX.
+    void setInternetCheck(uint32_t ttlMs, uint32_t intervalMs = 0);
+    // Destinos probados en orden (empezando por el último que respondió)
+    // hasta que uno da OK. De fábrica: clients3.google.com y
+    // connectivitycheck.gstatic.com (/generate_204); clearInternetProbes() los
+    // quita (p. ej. para usar uno de la LAN). Modos, del más caro al más barato:
+    //   "http://host[:puerto]/ruta"  GET; OK si el estado es expectCode
+    //   "tcp://host:puerto"          OK si completa el handshake
+    //   "dns://host"                 OK si el resolver contesta una consulta
+    //   "ping://host" o "ping://gateway"  echo ICMP (el gateway solo prueba la LAN)
+    // ping:// y una resolución del cache de lwIP nunca dan INTERNET_OK: solo
+    // suman a sus estadísticas y a la clase LINK_UP_* de la ronda.
+    bool addInternetProbe(const char* url, uint16_t expectCode = 204);
+    void clearInternetProbes();
+    void onInternetChange(InternetCallback cb);
+    // ms desde el último veredicto (UINT32_MAX si todavía no hay)
+    uint32_t getInternetCheckAgeMs() const;
+    // ida y vuelta (ms) de la última sonda exitosa: consulta, handshake,
+    // GET → línea de estado o echo → reply según el modo
+    uint32_t getInternetRttMs() const;
+    // Detalle del último chequeo: un GET que vuelve con 200/302 en vez del
+    // código esperado es un portal del hotel, no "sin Internet" (un 4xx/5xx
+    // sí cuenta como fallo del destino). Solo los
+    // destinos http:// detectan portales (tcp/dns/ping no ven el contenido).
+    InternetState getInternetState() const;
+    uint8_t getInternetProbeCount() const;
+    bool getInternetProbeStats(uint8_t index, ProbeStats& out) const;
+
+    // ==== Salud del enlace ====
+    // Cada sampleMs update() toma una muestra (RSSI, caídas, reconexiones,
+    // rtt de las sondas de Internet) en un anillo fijo de AWM_HEALTH_SAMPLES.
+    // getLinkQuality() (0..100) se recalcula con cada muestra: leerlo es O(1),
+    // p. ej. para frenar subidas antes de que el enlace se caiga.
+    void setHealthMonitor(bool enabled, uint32_t sampleMs = 5000);
+    uint8_t getLinkQuality() const;
+    HealthReport getHealthReport() const;    // EWMA/tendencia de RSSI, caídas, reconexión y latencia en la ventana
+    // Serie cruda, de la muestra más vieja a la más nueva; devuelve cuántas copió
+    uint8_t getHealthSamples(HealthSample* out, uint8_t max) const;
+
+    // ==== Lease DHCP cacheado (opcional) ====
+    // IP/gateway/máscara/DNS del último DHCP se reutilizan como IP estática en
+    // la próxima conexión a la misma red (sin esperar DHCP). Si el gateway no
+    // contesta ARP, o si otro equipo responde por la IP, se vuelve a DHCP.
+    // maxAgeS acota la reutilización desde que se obtuvo el lease; sin hora
+    // válida al arrancar (NTP o copia en RTC) no se reutiliza. 0 = sin vencimiento.
+    void setLeaseCache(bool enabled, uint32_t maxAgeS = 86400);
+
+    // ==== Redes guardadas (/wifi.json) ====
+    // pass: passphrase (8..63) o PSK en 64 hex; se guarda siempre la PSK.
+    // Mayor prioridad = preferida si está a la vista. Con la lista llena se
+    // descarta la de menor prioridad y éxito más antiguo.
+    bool addNetwork(const String& ssid, const String& pass, uint8_t priority = 0);
+    bool removeNetwork(const String& ssid);
+    uint8_t getNetworkCount() const;
+
+    // ==== Provisión en caliente (/save) ====
+    // ms desde el POST /save hasta tener IP en la última provisión (0 = ninguna aún)
+    uint32_t getLastProvisionMs() const;
+
 private:
     // ---------- portal AP/DNS/HTTP ----------
     void setupAP();
@@ -184,23 +411,91 @@ private:
     void redirectToRoot();
     uint8_t softAPStationCount();
 
+    // Páginas del portal (mismo orden que AWM_PORTAL_ASSETS del bundle embebido)
+    enum Pagina : uint8_t { PAG_INDEX, PAG_SUCCESS, PAG_ERROR, PAG_COUNT };
+
     // HTTP handlers
     void handleRoot();
     void handleSave();
+    void handleStatus();
     void handleScan();
+    bool iniciarEscaneo();
+    void enviarResultadoEscaneo(bool pendiente);
+    void escribirEscaneoJson(AwmJsonWriter& w, size_t limit, int minRssi) const;
+
+    // SSE (/events)
+    void handleEvents();
+    void sseTask();
+    void sseEnviar(const char* evento, const std::function<void(AwmJsonWriter&)>& data,
+                   WiFiClient* solo = nullptr);
+    void sseEnviarEscaneo(WiFiClient* solo = nullptr);
+    void sseEstadoConexion(const char* estado, WiFiClient* solo = nullptr);
+    void sseEstadoProvision(WiFiClient* solo = nullptr);
+    uint8_t sseClientes();
+    void sseCerrarTodos();
+    void escaneoTask();
     void handleNotFound();
     void mostrarPaginaError(const String& mensajeFallback);
+    bool enviarPagina(Pagina p, int code = 200);
+    bool enviarArchivo(const String& path, const char* contentType,
+                       int code = 200, bool cacheable = false);
     void handleErase();  // nueva linea para eliminar desde el sitio.
 
+    // Provisión en caliente: /save prueba la red sin reiniciar
+    enum ProvEstado : uint8_t { PROV_IDLE, PROV_PROBANDO, PROV_OK, PROV_FALLO };
+    void provisionTask();
+    void finalizarProvision(ProvEstado fin, const char* motivo);
+    void escribirEstadoProvision(AwmJsonWriter& w) const;
+    void enviarEstadoProvision(int code);
+
+    // ---------- conexión / botón (avanzados desde update()) ----------
+    enum BotonFase : uint8_t { BTN_INACTIVO, BTN_VENTANA, BTN_PRESIONADO };
+    enum ConnOrigen : uint8_t { CONN_USUARIO, CONN_RUN, CONN_RECONEXION };
+    enum ConnFase : uint8_t { FASE_MODO, FASE_ESCANEO, FASE_BEGIN, FASE_ESPERA, FASE_GATEWAY };
+    bool iniciarConexion(ConnOrigen origen, uint32_t timeoutMs);
+    void connectTask();
+    void ordenarCandidatos(bool conEscaneo);
+    void prepararCandidato();
+    void siguienteCandidato();
+    void terminarConexion(bool ok);
+    void aplicarFallback();
+    void botonTask();
+
+    // ---------- enlace STA por eventos ----------
+    void registrarEventosWiFi();
+    void linkTask();
+    bool enlaceConIp();
+    DisconnectClass estrategiaCaida(DisconnectClass c, bool intento = true);   // intento=false: la caída
+
     // ---------- credenciales ----------
     void loadCredentials();
-    void saveCredentials(String ssid, String password);
+    void saveCredentials();
+    int  indiceRed(const String& s) const;
+    int  agregarRed(const String& s, const String& psk, int prio = -1);
+    void seleccionarRed(int i);
+    bool recordarRed(uint32_t assocMs);
+
+    // ---------- lease DHCP cacheado (/lease.json) ----------
+    void cargarLease();
+    void capturarLease();
+    void guardarLease();
+    void borrarLease();
+    void leaseTask();
     void eraseCredentials();
     bool isProtectedJson(const String& name) const;
     void eraseJsonInDir(const char* path);
 
-    // ---------- NTP ----------
+    // ---------- NTP / hora en RTC ----------
     void sincronizarHoraNTP();
+    void ntpTask();
+    void guardarHoraRtc();
+    void restaurarHoraRtc();
+
+    // ---------- chequeo de Internet ----------
+    void internetTask();
+    void saludTask();
+    void lanzarSondaNet();
+    void veredictoNet(InternetState e);
 
     // ---------- LED FSM ----------
     void ledAutoUpdate();
@@ -208,10 +503,27 @@ private:
     void ledSet(LedPattern p);
 
     // ---------- datos ----------
-    // credenciales y HTML
+    // credenciales de la red activa y HTML (password = PSK en 64 hex, nunca la passphrase)
     String ssid, password;
+
+    // Redes guardadas (/wifi.json); ssid/password/pista son copia de redes[redActual]
+    struct Red {
+        String   ssid, psk;        // PSK 64 hex, o la clave tal cual si no es passphrase WPA
+        uint8_t  prio     = 0;
+        uint8_t  bssid[6] = {0};
+        uint8_t  canal    = 0;     // 0 = sin pista de asociación
+        uint8_t  fallos   = 0;     // ventanas agotadas seguidas (solo RAM)
+        uint32_t ok       = 0;     // epoch del último éxito (0 = desconocido)
+        uint32_t ms       = 0;     // begin() → asociado en el último éxito
+    };
+    std::vector<Red> redes;
+    String ultimaRed;              // SSID de la última conexión exitosa
+    int    redActual = -1;
     String htmlPathPrefix = "/";   // raíz del FS por defecto
 
+    // Assets del portal en LittleFS: variantes .gz y ETag resueltos una sola vez
+    AwmAssets assets;
+
     // servidor / dns
     WebServer server{80};
     DNSServer dns;
@@ -243,16 +555,173 @@ private:
     // conexión
     bool connected = false;
     bool autoReconnect = true;
-    unsigned long ultimoIntentoWiFi = 0;
+    unsigned long ultimoFalloWiFi = 0;   // la espera del backoff corre desde acá
+
+    // Enlace STA: lo escriben los callbacks de eventos (en ESP32, otra tarea) y
+    // lo lee update(). ESP8266 entrega los eventos en el mismo contexto que loop().
+#if defined(ESP32)
+    std::atomic<LinkState> linkEstado{LinkState::DOWN};
+    std::atomic<uint8_t>   linkMotivo{0};   // reason del último STA_DISCONNECTED (0 = ninguno)
+#else
+    volatile LinkState linkEstado = LinkState::DOWN;
+    volatile uint8_t   linkMotivo = 0;
+    WiFiEventHandler evAsociado, evDesconectado, evConIp;   // vivos mientras existan
+#endif
+    LinkState linkAvisado = LinkState::DOWN;   // último estado entregado por linkTask
+    LinkCallback linkCb;
+    bool eventosOn = false;
+    unsigned long linkSondeoAt = 0;
+    static constexpr unsigned long LINK_SONDEO_MS = 1000;   // respaldo con WiFi.status()
+
+    // Caídas: motivo, estrategia y tiempo de recuperación
+    uint8_t ultimoMotivo = 0;
+    DisconnectClass ultimaClase = DisconnectClass::NONE;   // clase del último fallo
+    uint8_t claseSeguidas = 0;                             // fallos seguidos de esa clase
+    DisconnectClass caidaClase = DisconnectClass::NONE;    // clase que abrió la caída en curso
+    unsigned long caidaAt = 0;                             // 0 = sin caída en curso
+    static constexpr uint8_t N_CLASES = (uint8_t)DisconnectClass::OTHER + 1;   // OTHER es la última
+    RecoveryStats recStats[N_CLASES];                      // por DisconnectClass
+    uint32_t esperaReintentoMs = 10000;                    // espera actual (según la clase)
+    static constexpr unsigned long MOTIVO_GRACIA_MS  = 250;    // motivos viejos tras begin()
+    static constexpr unsigned long AUTH_REINTENTO_MS = 300000; // clave rechazada: 5 min
+
+    // conexión asíncrona (beginConnect / run / reconexión → connectTask)
+    ConnectState connState = ConnectState::IDLE;
+    ConnectCallback connCb;
+    ConnOrigen connOrigen = CONN_USUARIO;   // qué hacer al terminar (NTP, fallback, SMART)
+    ConnFase   connFase   = FASE_MODO;
+    unsigned long connStart = 0;
+    unsigned long connFaseAt = 0;           // begin() del paso actual (pista o barrido)
+    uint32_t connTimeoutMs  = 0;            // ventana máxima por red
+    uint32_t connVentanaMs  = 0;            // ventana del candidato actual (adaptativa)
+    bool connConPista = false;              // el paso actual usa BSSID/canal guardados
+    bool connEscaneo  = false;              // ya se escaneó en este intento
+    unsigned long connScanPrevio = 0;       // lastScanAt al lanzar el escaneo
+    struct Candidato { uint8_t red; uint8_t canal; int8_t rssi; };  // canal 0 = sin escaneo
+    std::vector<Candidato> connCands;       // redes a probar, mejor primero
+    uint8_t connCandIdx = 0;
+    static constexpr unsigned long RED_VENTANA_MIN_MS = 3000;
+
+    // Pista de asociación: BSSID/canal del último AP de la red activa. Con ella
+    // begin() va directo a ese AP sin barrer todos los canales.
+    uint8_t pistaBssid[6] = {0};
+    uint8_t pistaCanal    = 0;
+    bool    pistaValida   = false;
+    static constexpr unsigned long PISTA_VENTANA_MS = 3000; // luego, barrido completo
+    uint32_t lastConnectMs = 0;
+
+    // Lease DHCP cacheado (setLeaseCache)
+    struct Lease {
+        String   ssid;
+        uint32_t ip = 0, gw = 0, mask = 0, dns1 = 0, dns2 = 0;
+        uint32_t t  = 0;          // epoch en que se obtuvo (0 = hora aún desconocida)
+    };
+    Lease    lease;
+    bool     leaseOn        = false;
+    bool     leaseCargado   = false;   // /lease.json ya leído
+    bool     leaseValido    = false;
+    bool     leaseRevisado  = false;   // vencimiento ya evaluado con hora válida
+    bool     leaseAplicado  = false;   // WiFi.config() estático vigente en el STA
+    bool     connConLease   = false;   // el intento actual usa el lease
+    uint32_t leaseMaxAgeS   = 86400;
+    unsigned long gwCheckAt = 0, gwArpAt = 0;
+    unsigned long leaseCapturaMs = 0;  // millis() de la captura (para fecharlo sin hora)
+    static constexpr unsigned long LEASE_GW_TIMEOUT_MS = 1000; // ARP al gateway
+    static constexpr unsigned long LEASE_DAD_MS        = 300;  // nadie más con la IP
+    static constexpr unsigned long LEASE_ARP_EVERY_MS  = 200;
+    static constexpr unsigned long CONNECT_TIMEOUT_MS = 15000;
+
+    // SNTP y copia de la hora en RTC
+    // Buffers fijos: SNTP guarda los punteros que recibe configTime()
+    static constexpr size_t NTP_HOST_MAX = 63;
+    char ntpServidores[3][NTP_HOST_MAX + 1] = { "pool.ntp.org", "time.nist.gov", "" };
+    TimeSyncCallback ntpCb;
+    bool ntpIniciado     = false;   // configTime() ya llamado
+    bool ntpSincronizado = false;   // SNTP respondió en este arranque
+    bool ntpAvisoLento   = false;
+    unsigned long ntpDesde = 0;
+    unsigned long rtcGuardadoAt = 0;
+    static constexpr unsigned long NTP_AVISO_MS     = 4000;   // log si SNTP tarda más
+    static constexpr unsigned long RTC_GUARDADO_MS  = 1000;   // error máx. tras reinicio ≈ esto + arranque
+
+    // Chequeo de Internet: una sonda a la vez, veredicto cacheado
+    struct SondaNet { String host, ruta; uint16_t puerto; uint16_t espera; uint8_t modo; ProbeStats st; };  // modo: AwmProbe::Mode
+    std::vector<SondaNet> netSondas;   // por defecto: dos generate_204 (ver ctor)
+    InternetCallback netCb;
+    InternetState netEstado = InternetState::LINK_DOWN;
+    bool     netOk      = false;   // netEstado == INTERNET_OK
+    bool     netRondaDns = false;  // algún destino de la ronda resolvió
+    bool     netRondaUsaDns = false; // algún destino de la ronda era un nombre
+    int16_t  netRondaCodigo = 0;   // estado HTTP inesperado visto en la ronda
+    bool     netValido  = false;   // hay veredicto para el enlace actual
+    bool     netPedido  = false;   // hayInternet() lo encontró vencido
+    bool     netEnCurso = false;
+    uint8_t  netPrimera = 0;       // último destino que respondió (abre la ronda)
+    uint8_t  netIdx     = 0;       // intento dentro de la ronda
+    unsigned long netAt = 0;       // hora del veredicto
+    uint32_t netRttMs   = 0;       // rtt de la última sonda exitosa
+    uint32_t netTtlMs       = 30000;
+    uint32_t netIntervaloMs = 0;   // 0 = solo bajo demanda
+    static constexpr uint32_t NET_TIMEOUT_MS = 3000;   // por destino
+    static constexpr uint8_t  NET_MAX_SONDAS = 8;
+
+    // Monitor de salud: muestras a período fijo, sin heap
+    AwmHealth salud;
+    bool     saludOn = true;
+    uint32_t saludPeriodoMs = 5000;
+    unsigned long saludAt = 0;
+
+    // ventana del botón al arrancar (run() solo la abre; la atiende update())
+    BotonFase btnFase = BTN_INACTIVO;
+    unsigned long btnT0 = 0;
+    static constexpr unsigned long BOOT_WINDOW_MS = 2000;
 
     // scan helper
     unsigned long ultimoScan = 0;
     static constexpr unsigned long SCAN_INTERVAL_MS = 15000;
-    static constexpr unsigned long SCAN_CACHE_MS    = 1500; // (si usás cache en el futuro)
-    String lastScanJson;
+    static constexpr unsigned long SCAN_CACHE_MS    = 10000; // TTL por defecto de /scan
+    uint32_t scanCacheMs = SCAN_CACHE_MS;
+    struct ScanEntry {           // una por SSID (datos del BSSID más fuerte)
+        char    ssid[33];
+        int8_t  rssi    = -128;
+        uint8_t channel = 0;
+        uint8_t bssids  = 0;       // cuántos APs anuncian este SSID
+        bool    secure  = false;
+    };
+    std::vector<ScanEntry> scanResults;  // último escaneo completo (cache de /scan)
+    bool scanHasResult = false;
     unsigned long lastScanAt = 0;
-    bool scanning = false;
+    bool scanning = false;               // escaneo asíncrono en curso
     unsigned long scanningUntil = 0;
+    unsigned long scanStartedAt = 0;
+    static constexpr unsigned long SCAN_TIMEOUT_MS = 10000; // scan colgado → descartar
+    static constexpr unsigned long SCAN_RETRY_MS   = 1500;  // sugerido al cliente en 202
+    static constexpr unsigned long SCAN_JOIN_MS    = 2 * SCAN_RETRY_MS; // TTL mínimo
+    ScanStats scanStats;
+
+    // SSE (/events)
+    WiFiClient sseClients[AWM_SSE_MAX_CLIENTS];
+    unsigned long sseLastTick = 0;
+    unsigned long sseLastPing = 0;
+    bool sseLastLink = false;
+    static constexpr unsigned long SSE_SCAN_INTERVAL_MS = 30000; // re-escaneo con suscriptores
+    static constexpr unsigned long SSE_PING_MS          = 15000; // keep-alive sin timeout
+    static constexpr unsigned long SSE_WRITE_TIMEOUT_MS = 200;   // ESP8266: tope de write()
+
+    // provisión en caliente (/save)
+    ProvEstado provEstado = PROV_IDLE;
+    String provSsid, provPass;           // credenciales a prueba (aún no persistidas)
+    AwmPmk provPmk;                      // PMK de provPass, derivada por tramos
+    bool provDerivando = false;          // provPass todavía es passphrase
+    const char* provMotivo = nullptr;    // causa del último fallo ("auth", "no_ssid", "timeout")
+    bool provIniciado = false;           // WiFi.begin() ya lanzado (espera a que termine un scan)
+    unsigned long provStart = 0;         // llegada del POST /save
+    unsigned long provBeginAt = 0;       // WiFi.begin() con las credenciales nuevas
+    unsigned long provFinAt = 0;
+    uint32_t lastProvisionMs = 0;        // time-to-online de la última provisión exitosa
+    static constexpr unsigned long PROV_TIMEOUT_MS = CONNECT_TIMEOUT_MS;
+    static constexpr unsigned long PROV_GRACE_MS   = 3000;  // ignorar estados viejos del STA
+    static constexpr unsigned long PROV_CLOSE_MS   = 5000;  // margen para que la página vea la IP
 
     // GPIO
     uint8_t ledPin, buttonPin;
@@ -268,8 +737,13 @@ private:
     std::vector<String> _protectedExact;
 
     // [NEW] Parámetros de reconexión configurables
-    uint32_t reconnectBackoffMs = 10000;  // default 10s (antes fijo)
+    uint32_t reconnectBackoffMs = 10000;  // base del backoff exponencial
+    float    backoffMult        = 2.0f;
+    uint32_t backoffCapMs       = 300000;
+    uint8_t  backoffJitterPct   = 50;
+    AwmBackoff backoff;                   // sembrado con la MAC en begin()
     uint32_t reconnectAttemptMs = 5000;   // default 5s  (antes fijo)
+    uint32_t reconnectBudgetMs  = 20;     // tope por update() del driver de conexión
 
     // [NEW] Bandera para indicar que hay un AP/portal externo activo
     bool externalApActive = false;        // usado para mantener AP_STA en reintentos
@@ -0,0 +1,64 @@
+// awm_heap.h
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/*
+ * Contador de heap para test/host: reemplaza new/delete globales y lleva los
+ * bytes vivos y el pico. Define operator new, así que va en un solo .cpp por
+ * ejecutable (cada prueba es uno).
+ *
+ *   size_t pico = awmPicoHeap([&] { ... });   // bytes por encima de lo ya vivo
+ */
+
+struct AwmHeap {
+  size_t vivos   = 0;
+  size_t pico    = 0;
+  size_t pedidos = 0;   // llamadas a new
+};
+
+inline AwmHeap& awmHeap() { static AwmHeap h; return h; }
+
+// Prefijo con el tamaño pedido; alineado como lo haría malloc. noinline: si
+// gcc los expande en el llamador, confunde el prefijo con un acceso fuera
+// del bloque (-Warray-bounds, -Wmismatched-new-delete).
+static constexpr size_t AWM_HEAP_PREFIJO = alignof(std::max_align_t);
+
+__attribute__((noinline)) void* operator new(size_t n) {
+  unsigned char* p = static_cast<unsigned char*>(std::malloc(n + AWM_HEAP_PREFIJO));
+  if (!p) throw std::bad_alloc();
+  *reinterpret_cast<size_t*>(p) = n;
+  AwmHeap& h = awmHeap();
+  h.vivos += n;
+  h.pedidos++;
+  if (h.vivos > h.pico) h.pico = h.vivos;
+  return p + AWM_HEAP_PREFIJO;
+}
+
+__attribute__((noinline)) void operator delete(void* q) noexcept {
+  if (!q) return;
+  unsigned char* p = static_cast<unsigned char*>(q) - AWM_HEAP_PREFIJO;
+  awmHeap().vivos -= *reinterpret_cast<size_t*>(p);
+  std::free(p);
+}
+
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete[](void* q) noexcept { operator delete(q); }
+void operator delete(void* q, size_t) noexcept { operator delete(q); }
+void operator delete[](void* q, size_t) noexcept { operator delete(q); }
+
+// Tamaño pedido de un bloque vivo de operator new.
+inline size_t awmHeapTamano(const void* q) {
+  return *reinterpret_cast<const size_t*>(static_cast<const unsigned char*>(q) - AWM_HEAP_PREFIJO);
+}
+
+// Pico de heap de fn() por encima de lo que ya estaba vivo al llamarla.
+template <class F>
+size_t awmPicoHeap(F fn) {
+  AwmHeap& h = awmHeap();
+  const size_t base = h.vivos;
+  h.pico = base;
+  fn();
+  return h.pico - base;
+}
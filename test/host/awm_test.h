@@ -0,0 +1,42 @@
+// awm_test.h
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+
+/*
+ * Mini arnés para las pruebas de test/host: CHECK() informa y sigue, el
+ * main devuelve awmFallos() (0 = todo bien). Sin dependencias.
+ */
+
+inline int& awmFallosRef() { static int n = 0; return n; }
+inline int  awmFallos()    { return awmFallosRef(); }
+
+#define CHECK(cond) do {                                                  \
+    if (!(cond)) {                                                        \
+      std::printf("  FALLA %s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+      awmFallosRef()++;                                                   \
+    }                                                                     \
+  } while (0)
+
+#define CHECK_STR(a, b) do {                                              \
+    const char* _a = (a); const char* _b = (b);                           \
+    if (std::strcmp(_a, _b) != 0) {                                       \
+      std::printf("  FALLA %s:%d: \"%s\" != \"%s\"\n", __FILE__, __LINE__, _a, _b); \
+      awmFallosRef()++;                                                   \
+    }                                                                     \
+  } while (0)
+
+// Microsegundos por llamada de fn(), promedio de n vueltas.
+template <class F>
+double awmMedirUs(unsigned n, F fn) {
+  const auto t0 = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < n; i++) fn();
+  const std::chrono::duration<double, std::micro> dt = std::chrono::steady_clock::now() - t0;
+  return dt.count() / n;
+}
+
+inline int awmResumen(const char* prueba) {
+  std::printf("%s: %s\n", prueba, awmFallos() ? "FALLA" : "OK");
+  return awmFallos() ? 1 : 0;
+}
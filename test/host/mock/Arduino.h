@@ -0,0 +1,62 @@
+// Arduino.h (doble para la PC)
+#pragma once
+
+/*
+ * Lo mínimo del core de Arduino para compilar los helpers header-only de src/
+ * en la PC (test/host). No simula hardware: solo tipos, millis(), yield() y
+ * un String sobre std::string con lo que usan los helpers y las pruebas.
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <chrono>
+#include <string>
+
+inline unsigned long millis() {
+  using namespace std::chrono;
+  static const steady_clock::time_point t0 = steady_clock::now();
+  return (unsigned long)duration_cast<milliseconds>(steady_clock::now() - t0).count();
+}
+
+inline void yield() {}
+
+class String {
+public:
+  String() {}
+  String(const char* s) : _s(s ? s : "") {}
+  String(const std::string& s) : _s(s) {}
+  explicit String(unsigned long v) : _s(std::to_string(v)) {}
+  explicit String(int v) : _s(std::to_string(v)) {}
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned int length() const { return (unsigned int)_s.size(); }
+  bool isEmpty() const { return _s.empty(); }
+  bool reserve(unsigned int n) { _s.reserve(n); return true; }
+  int indexOf(const char* t) const {
+    const size_t i = _s.find(t);
+    return i == std::string::npos ? -1 : (int)i;
+  }
+  int indexOf(const String& t) const { return indexOf(t.c_str()); }
+  bool endsWith(const char* t) const {
+    const size_t n = std::strlen(t);
+    return _s.size() >= n && _s.compare(_s.size() - n, n, t) == 0;
+  }
+
+  String& operator+=(const String& o) { _s += o._s; return *this; }
+  String& operator+=(const char* o)   { _s += o; return *this; }
+  String& operator+=(char c)          { _s += c; return *this; }
+  bool operator==(const String& o) const { return _s == o._s; }
+  bool operator==(const char* o) const   { return _s == o; }
+  bool operator!=(const String& o) const { return _s != o._s; }
+
+  friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+  friend String operator+(const String& a, const char* b)   { return String(a._s + b); }
+  friend String operator+(const char* a, const String& b)   { return String(a + b._s); }
+
+private:
+  std::string _s;
+};
@@ -0,0 +1,130 @@
+// WebFs.h (doble para la PC)
+#pragma once
+#include <Arduino.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Dobles de WebServer, FS y File para probar AWM_Asset.h en test/host.
+ * MockFs guarda los archivos en memoria; MockServer no guarda el cuerpo que
+ * se envía: solo cuenta bytes y los hashea (FNV-1a), así el heap medido es
+ * el del código bajo prueba y no el del doble.
+ */
+
+class MockFile {
+public:
+  MockFile() {}
+  explicit MockFile(const std::string* datos) : _d(datos) {}
+
+  explicit operator bool() const { return _d != nullptr; }
+  bool   isDirectory() const { return false; }
+  size_t size() const { return _d ? _d->size() : 0; }
+  int    available() const { return _d ? (int)(_d->size() - _pos) : 0; }
+  bool   seek(size_t pos) { _pos = pos <= size() ? pos : size(); return true; }
+  void   close() { _d = nullptr; _pos = 0; }
+
+  size_t read(uint8_t* buf, size_t n) {
+    const size_t quedan = (size_t)available();
+    if (n > quedan) n = quedan;
+    if (n) std::memcpy(buf, _d->data() + _pos, n);
+    _pos += n;
+    return n;
+  }
+
+  // Como File::readString() del core de ESP8266: reserva lo que queda y lee
+  // todo. El Stream::readString() de ESP32 crece de a un carácter, peor aún.
+  String readString() {
+    String s;
+    s.reserve((unsigned int)available());
+    uint8_t buf[256];
+    size_t n;
+    while ((n = read(buf, sizeof(buf) - 1)) > 0) {
+      buf[n] = 0;
+      s += reinterpret_cast<const char*>(buf);
+    }
+    return s;
+  }
+
+private:
+  const std::string* _d = nullptr;
+  size_t _pos = 0;
+};
+
+class MockFs {
+public:
+  void add(const char* path, std::string datos) { _archivos.emplace_back(path, std::move(datos)); }
+
+  bool exists(const String& path) const { return buscar(path) != nullptr; }
+  MockFile open(const String& path, const char*) {
+    aperturas++;
+    const std::string* d = buscar(path);
+    return d ? MockFile(d) : MockFile();
+  }
+
+  unsigned aperturas = 0;
+
+private:
+  const std::string* buscar(const String& path) const {
+    for (const auto& a : _archivos) {
+      if (a.first == path.c_str()) return &a.second;
+    }
+    return nullptr;
+  }
+
+  std::vector<std::pair<std::string, std::string>> _archivos;
+};
+
+class MockServer {
+public:
+  // Nuevo request: cabeceras del navegador (nullptr = ausente) y respuesta en cero.
+  void request(const char* acceptEncoding, const char* ifNoneMatch = nullptr) {
+    _accept = acceptEncoding ? acceptEncoding : "";
+    _inm    = ifNoneMatch ? ifNoneMatch : "";
+    _resp.clear();
+    code = 0; contentLength = 0; cuerpo = 0; hash = 2166136261UL;
+  }
+
+  String header(const char* nombre) const {
+    if (!std::strcmp(nombre, "Accept-Encoding")) return String(_accept);
+    if (!std::strcmp(nombre, "If-None-Match"))   return String(_inm);
+    return String();
+  }
+
+  void sendHeader(const String& nombre, const String& valor) {
+    _resp.emplace_back(nombre.c_str(), valor.c_str());
+  }
+  void setContentLength(size_t n) { contentLength = n; }
+  void send(int c, const char*, const String& contenido) {
+    code = c;
+    sendContent(contenido.c_str(), contenido.length());
+  }
+  void sendContent(const char* p, size_t n) {
+    cuerpo += n;
+    for (size_t i = 0; i < n; i++) { hash ^= (uint8_t)p[i]; hash *= 16777619UL; }
+  }
+
+  // Valor de una cabecera de la respuesta ("" si no se envió).
+  const char* respHeader(const char* nombre) const {
+    for (const auto& h : _resp) {
+      if (h.first == nombre) return h.second.c_str();
+    }
+    return "";
+  }
+
+  int      code = 0;
+  size_t   contentLength = 0;
+  size_t   cuerpo = 0;          // bytes de cuerpo enviados
+  uint32_t hash = 2166136261UL; // FNV-1a del cuerpo enviado
+
+private:
+  std::string _accept, _inm;
+  std::vector<std::pair<std::string, std::string>> _resp;
+};
+
+// FNV-1a de un contenido, para comparar con MockServer::hash.
+inline uint32_t fnv1a(const std::string& d) {
+  uint32_t h = 2166136261UL;
+  for (unsigned char c : d) { h ^= c; h *= 16777619UL; }
+  return h;
+}
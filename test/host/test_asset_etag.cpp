@@ -0,0 +1,143 @@
+// test_asset_etag.cpp — ETag/304 y variante gzip de AwmAssets (AWM_Asset.h):
+// bytes de cuerpo enviados a lo largo de varias visitas al portal.
+#include <Arduino.h>
+#include "AWM_Asset.h"
+#include "mock/WebFs.h"
+#include "awm_test.h"
+
+static std::string pagina(size_t n, char relleno) {
+  std::string s = "<!doctype html><html><body>\n";
+  s.append(n - s.size(), relleno);
+  return s;
+}
+
+// Visitas de un navegador: la primera sin ETag, las demás con el último
+// recibido. Devuelve los bytes de cuerpo enviados en total.
+static size_t visitas(AwmAssets& assets, MockFs& fs, const char* accept, int n,
+                      bool cacheable, std::string* etag = nullptr) {
+  MockServer server;
+  std::string ultimo;
+  size_t total = 0;
+  for (int i = 0; i < n; i++) {
+    server.request(accept, ultimo.empty() ? nullptr : ultimo.c_str());
+    CHECK(assets.send(server, fs, "/index.html", "text/html", 200, cacheable));
+    total += server.cuerpo;
+    if (*server.respHeader("ETag")) ultimo = server.respHeader("ETag");
+  }
+  if (etag) *etag = ultimo;
+  return total;
+}
+
+int main() {
+  const std::string plano = pagina(12 * 1024, 'a');
+  const std::string gz    = pagina(3 * 1024, 'z');   // hace de versión comprimida
+
+  // ---- Solo archivo plano ----
+  {
+    MockFs fs;
+    fs.add("/index.html", plano);
+    AwmAssets assets;
+    MockServer server;
+
+    server.request("gzip");
+    CHECK(assets.send(server, fs, "/index.html", "text/html", 200, true));
+    CHECK(server.code == 200 && server.cuerpo == plano.size() && server.hash == fnv1a(plano));
+    CHECK(*server.respHeader("ETag") == '"');
+    CHECK(std::strcmp(server.respHeader("Cache-Control"), "public, max-age=0") == 0);
+    CHECK(*server.respHeader("Content-Encoding") == 0);   // sin .gz no se anuncia gzip
+    CHECK(*server.respHeader("Vary") == 0);
+    const std::string etag = server.respHeader("ETag");
+
+    server.request("gzip", etag.c_str());
+    CHECK(assets.send(server, fs, "/index.html", "text/html", 200, true));
+    CHECK(server.code == 304 && server.cuerpo == 0);
+    CHECK(etag == server.respHeader("ETag"));
+
+    server.request("gzip", "\"00000000\"");                // ETag viejo → cuerpo completo
+    CHECK(assets.send(server, fs, "/index.html", "text/html", 200, true));
+    CHECK(server.code == 200 && server.cuerpo == plano.size());
+
+    // Respuestas no cacheables (p. ej. /save): ni ETag ni 304.
+    server.request("gzip", etag.c_str());
+    CHECK(assets.send(server, fs, "/index.html", "text/html", 200, false));
+    CHECK(server.code == 200 && server.cuerpo == plano.size());
+    CHECK(*server.respHeader("ETag") == 0);
+
+    const int N = 10;
+    const size_t conEtag = visitas(assets, fs, "gzip", N, true);
+    const size_t sinEtag = visitas(assets, fs, "gzip", N, false);
+    CHECK(conEtag == plano.size());                       // solo la primera visita
+    CHECK(sinEtag == N * plano.size());
+    std::printf("  %d visitas, 12 KB: con ETag %zu B · sin ETag %zu B\n", N, conEtag, sinEtag);
+  }
+
+  // ---- Con index.html.gz ----
+  {
+    MockFs fs;
+    fs.add("/index.html", plano);
+    fs.add("/index.html.gz", gz);
+    AwmAssets assets;
+    MockServer server;
+
+    server.request("gzip, deflate, br");
+    CHECK(assets.send(server, fs, "/index.html", "text/html", 200, true));
+    CHECK(server.code == 200 && server.cuerpo == gz.size() && server.hash == fnv1a(gz));
+    CHECK(server.contentLength == gz.size());
+    CHECK(std::strcmp(server.respHeader("Content-Encoding"), "gzip") == 0);
+    CHECK(std::strcmp(server.respHeader("Vary"), "Accept-Encoding") == 0);
+    const std::string etagGz = server.respHeader("ETag");
+
+    server.request("identity");
+    CHECK(assets.send(server, fs, "/index.html", "text/html", 200, true));
+    CHECK(server.code == 200 && server.cuerpo == plano.size() && server.hash == fnv1a(plano));
+    CHECK(*server.respHeader("Content-Encoding") == 0);
+    CHECK(std::strcmp(server.respHeader("Vary"), "Accept-Encoding") == 0);
+    const std::string etagPlano = server.respHeader("ETag");
+    CHECK(etagGz != etagPlano);                           // una variante por ETag
+
+    // El ETag de una variante no valida a la otra.
+    server.request("identity", etagGz.c_str());
+    CHECK(assets.send(server, fs, "/index.html", "text/html", 200, true));
+    CHECK(server.code == 200 && server.cuerpo == plano.size());
+    server.request("gzip", etagGz.c_str());
+    CHECK(assets.send(server, fs, "/index.html", "text/html", 200, true));
+    CHECK(server.code == 304 && server.cuerpo == 0);
+
+    // ".gz" se consulta al FS una vez por path, no en cada request.
+    const unsigned antes = fs.aperturas;
+    server.request("gzip", etagGz.c_str());
+    CHECK(assets.send(server, fs, "/index.html", "text/html", 200, true));
+    CHECK(fs.aperturas == antes + 1);
+
+    const int N = 10;
+    const size_t gzip     = visitas(assets, fs, "gzip", N, true);
+    const size_t identity = visitas(assets, fs, "identity", N, true);
+    const size_t sinCache = visitas(assets, fs, "identity", N, false);
+    CHECK(gzip == gz.size());
+    CHECK(identity == plano.size());
+    std::printf("  %d visitas: gzip+ETag %zu B · identity+ETag %zu B · identity sin ETag %zu B\n",
+                N, gzip, identity, sinCache);
+  }
+
+  // ---- clear(): contenido nuevo → ETag nuevo ----
+  {
+    MockFs fs1;
+    fs1.add("/index.html", plano);
+    AwmAssets assets;
+    std::string etag1, etag2;
+    visitas(assets, fs1, "", 1, true, &etag1);
+
+    MockFs fs2;
+    fs2.add("/index.html", pagina(12 * 1024, 'b'));
+    assets.clear();
+    visitas(assets, fs2, "", 1, true, &etag2);
+    CHECK(!etag1.empty() && etag1 != etag2);
+
+    MockServer server;
+    server.request("", etag1.c_str());
+    CHECK(assets.send(server, fs2, "/index.html", "text/html", 200, true));
+    CHECK(server.code == 200 && server.cuerpo == plano.size());
+  }
+
+  return awmResumen("test_asset_etag");
+}
@@ -0,0 +1,78 @@
+// test_asset_heap.cpp — pico de heap por request al enviar una página del
+// portal: el envío anterior (readString() + send) contra AwmAssets::send()
+// (AWM_Asset.h), que usa enviarArchivo().
+#include <Arduino.h>
+#include "AWM_Asset.h"
+#include "mock/WebFs.h"
+#include "awm_heap.h"
+#include "awm_test.h"
+
+// HTML sintético de n bytes
+static std::string pagina(size_t n) {
+  static const char kFila[] = "<div class=\"net\"><span>AyresWiFiManager</span></div>\n";
+  std::string s = "<!doctype html><html><body>\n";
+  while (s.size() < n) s += kFila;
+  s.resize(n);
+  return s;
+}
+
+// Envío anterior: el archivo entero a un String y de ahí al socket.
+static bool enviarAntes(MockServer& server, MockFs& fs, const String& path) {
+  MockFile file = fs.open(path, "r");
+  if (!file) return false;
+  server.send(200, "text/html", file.readString());
+  file.close();
+  return true;
+}
+
+int main() {
+  static const size_t TAMANOS[] = { 2 * 1024, 16 * 1024, 64 * 1024 };
+  const String path("/index.html");
+  size_t primero0 = 0, siguiente0 = 0;
+
+  for (size_t i = 0; i < sizeof(TAMANOS) / sizeof(TAMANOS[0]); i++) {
+    const size_t n = TAMANOS[i];
+    MockFs fs;
+    fs.add("/index.html", pagina(n));
+    const uint32_t h = fnv1a(pagina(n));
+    MockServer server;
+    AwmAssets assets;
+
+    server.request("gzip, deflate, br");
+    const size_t antes = awmPicoHeap([&] { CHECK(enviarAntes(server, fs, path)); });
+    CHECK(server.code == 200 && server.cuerpo == n && server.hash == h);
+
+    // Primer request: resuelve .gz y calcula el ETag; los siguientes ya no.
+    server.request("gzip, deflate, br");
+    const size_t primero = awmPicoHeap([&] {
+      CHECK(assets.send(server, fs, path, "text/html", 200, true));
+    });
+    CHECK(server.code == 200 && server.cuerpo == n && server.hash == h);
+    CHECK(server.contentLength == n);
+
+    server.request("gzip, deflate, br");
+    const size_t siguiente = awmPicoHeap([&] {
+      CHECK(assets.send(server, fs, path, "text/html", 200, true));
+    });
+    CHECK(server.code == 200 && server.cuerpo == n && server.hash == h);
+
+    std::printf("  %3zu KB: antes %6zu B · AwmAssets 1er request %3zu B, siguientes %3zu B"
+                " (+%d B de stack)\n", n / 1024, antes, primero, siguiente, AWM_STREAM_CHUNK);
+
+    CHECK(antes > n);                 // el archivo entero vive en el heap
+    CHECK(primero < 512 && siguiente < 512);
+    if (i == 0) { primero0 = primero; siguiente0 = siguiente; }
+    CHECK(primero == primero0);       // no depende del tamaño del archivo
+    CHECK(siguiente == siguiente0);
+  }
+
+  // Sin el archivo no se envía nada y el llamador puede usar su fallback.
+  MockFs vacio;
+  MockServer server;
+  AwmAssets assets;
+  server.request("");
+  CHECK(!assets.send(server, vacio, "/index.html", "text/html"));
+  CHECK(server.code == 0 && server.cuerpo == 0);
+
+  return awmResumen("test_asset_heap");
+}
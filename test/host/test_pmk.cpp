@@ -0,0 +1,59 @@
+// test_pmk.cpp — AwmPmk (AWM_Pmk.h) contra los vectores de IEEE 802.11i
+// (anexo H.4) y costo de derivar en cada conexión vs. guardar la PSK.
+#include <Arduino.h>
+#include "AWM_Pmk.h"
+#include "awm_test.h"
+
+static void derivar(const char* pass, const char* ssid, uint32_t paso, char out[65]) {
+  AwmPmk pmk;
+  pmk.begin(pass, ssid);
+  while (!pmk.step(paso)) {}
+  pmk.hex(out);
+}
+
+// Lo que hace el driver con una PSK guardada: pasar 64 hex a 32 bytes
+static void pskABytes(const char* hex, uint8_t out[32]) {
+  auto v = [](char c) { return (uint8_t)(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10); };
+  for (int i = 0; i < 32; i++) out[i] = (uint8_t)(v(hex[2*i]) << 4 | v(hex[2*i + 1]));
+}
+
+int main() {
+  static const struct { const char* pass; const char* ssid; const char* psk; } VECTORES[] = {
+    { "password", "IEEE",
+      "f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e" },
+    { "ThisIsAPassword", "ThisIsASSID",
+      "0dc0d6eb90555ed6419756b9a15ec3e3209b63df707dd508d14581f8982721af" },
+  };
+
+  char psk[65];
+  for (const auto& v : VECTORES) {
+    derivar(v.pass, v.ssid, AwmPmk::ITERACIONES * 2, psk);   // de una vez
+    CHECK_STR(psk, v.psk);
+    derivar(v.pass, v.ssid, 1, psk);                          // de a una iteración
+    CHECK_STR(psk, v.psk);
+    derivar(v.pass, v.ssid, 64, psk);                         // tramos de provisionTask
+    CHECK_STR(psk, v.psk);
+  }
+
+  AwmPmk sinBegin;
+  CHECK(sinBegin.done());
+
+  CHECK(AwmPmk::esHex(VECTORES[0].psk));
+  CHECK(!AwmPmk::esHex("password"));
+  CHECK(!AwmPmk::esHex("f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12"));     // 63
+  CHECK(!AwmPmk::esHex("g42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e"));
+
+  // Costo por conexión: passphrase → el driver deriva en cada begin();
+  // PSK guardada → solo decodifica el hex. En la placa cada derivación ronda
+  // los cientos de ms (ESP32) o ~1 s (ESP8266); en la PC, unos pocos ms.
+  uint8_t bytes[32];
+  const double usPbkdf2 = awmMedirUs(20, [&] { derivar("ThisIsAPassword", "ThisIsASSID", 256, psk); });
+  const double usPsk    = awmMedirUs(100000, [&] { pskABytes(VECTORES[1].psk, bytes); });
+  CHECK(bytes[0] == 0x0d && bytes[31] == 0xaf);
+  std::printf("  por conexión: PBKDF2 %.0f us · PSK guardada %.3f us (%.0fx)\n",
+              usPbkdf2, usPsk, usPsk > 0 ? usPbkdf2 / usPsk : 0.0);
+  std::printf("  compresiones SHA1 por derivación: %u\n", 2 * 2 * AwmPmk::ITERACIONES + 2);
+  CHECK(usPbkdf2 > usPsk * 100);
+
+  return awmResumen("test_pmk");
+}
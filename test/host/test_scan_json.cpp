@@ -0,0 +1,153 @@
+// test_scan_json.cpp — cuerpo de /scan para un escaneo sintético de 60 redes:
+// AwmJsonWriter (AWM_JsonWriter.h) contra el camino anterior
+// (DynamicJsonDocument + serializeJson a un String). Mide heap y tiempo.
+//
+// El camino ArduinoJson se compila solo si el Makefile lo encuentra
+// (ARDUINOJSON=<ruta a ArduinoJson/src>); si no, se mide solo AwmJsonWriter.
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "AWM_JsonWriter.h"
+#include "awm_heap.h"
+#include "awm_test.h"
+#if AWM_TEST_ARDUINOJSON
+  #include <ArduinoJson.h>
+#endif
+
+// Igual que AyresWiFiManager::ScanEntry
+struct ScanEntry {
+  char    ssid[33];
+  int8_t  rssi    = -128;
+  uint8_t channel = 0;
+  uint8_t bssids  = 0;
+  bool    secure  = false;
+};
+
+static std::vector<ScanEntry> escaneo(int n) {
+  std::vector<ScanEntry> v(n);
+  for (int i = 0; i < n; i++) {
+    ScanEntry& e = v[i];
+    if (i == 7)       std::snprintf(e.ssid, sizeof(e.ssid), "Casa \"Ayres\" 5G");
+    else if (i == 13) std::snprintf(e.ssid, sizeof(e.ssid), "oficina\\piso\t2");
+    else if (i == 21) std::snprintf(e.ssid, sizeof(e.ssid), "Café ñandú");
+    else              std::snprintf(e.ssid, sizeof(e.ssid), "AyresNet-%02d-%08X", i, 0x9E3779B1u * (i + 1));
+    e.rssi    = (int8_t)(-30 - i);                 // ya ordenado por señal
+    e.channel = (uint8_t)(1 + i % 13);
+    e.bssids  = (uint8_t)(1 + i % 3);
+    e.secure  = (i % 5) != 0;
+  }
+  return v;
+}
+
+// Mismo cuerpo que AyresWiFiManager::escribirEscaneoJson()
+static void escribirEscaneoJson(AwmJsonWriter& w, const std::vector<ScanEntry>& redes) {
+  w.raw('[');
+  size_t sent = 0;
+  for (const ScanEntry& e : redes) {
+    if (sent++) w.raw(',');
+    w.raw("{\"ssid\":");     w.str(e.ssid);
+    w.raw(",\"rssi\":");     w.num(e.rssi);
+    w.raw(",\"channel\":");  w.num(e.channel);
+    w.raw(",\"bssids\":");   w.num(e.bssids);
+    w.raw(",\"secure\":");   w.boolean(e.secure);
+    w.raw('}');
+  }
+  w.raw(']');
+}
+
+// Sink que hace de sendContent(): solo cuenta (o copia, para comparar).
+struct Salida {
+  size_t       bytes = 0;
+  std::string* copia = nullptr;
+};
+
+static size_t conWriter(const std::vector<ScanEntry>& redes, std::string* copia = nullptr) {
+  Salida s;
+  s.copia = copia;
+  AwmJsonWriter w([](void* ctx, const char* data, size_t len){
+    Salida* o = static_cast<Salida*>(ctx);
+    o->bytes += len;
+    if (o->copia) o->copia->append(data, len);
+  }, &s);
+  escribirEscaneoJson(w, redes);
+  w.flush();
+  return s.bytes;
+}
+
+#if AWM_TEST_ARDUINOJSON
+// DefaultAllocator de ArduinoJson usa malloc; este pasa por operator new
+// para que awm_heap.h cuente el documento.
+struct AsignadorContado {
+  void* allocate(size_t n) { return ::operator new(n); }
+  void  deallocate(void* p) { ::operator delete(p); }
+  void* reallocate(void* p, size_t n) {
+    void* q = ::operator new(n);
+    const size_t viejo = awmHeapTamano(p);
+    std::memcpy(q, p, viejo < n ? viejo : n);
+    ::operator delete(p);
+    return q;
+  }
+};
+typedef BasicJsonDocument<AsignadorContado> DocContado;
+
+// Camino anterior: documento con capacidad 64 + n·64 (mínimo 512), ahora con
+// los cinco campos, y serializado a un String que quedaba como cache de /scan.
+static bool conArduinoJson(const std::vector<ScanEntry>& redes, std::string& out) {
+  size_t cap = JSON_ARRAY_SIZE(redes.size()) + redes.size() * (JSON_OBJECT_SIZE(5) + 33);
+  if (cap < 512U) cap = 512U;
+  DocContado doc(cap);
+  JsonArray arr = doc.to<JsonArray>();
+  for (const ScanEntry& e : redes) {
+    JsonObject o = arr.createNestedObject();
+    o["ssid"]    = std::string(e.ssid);   // WiFi.SSID(i) era un String: se copia
+    o["rssi"]    = e.rssi;
+    o["channel"] = e.channel;
+    o["bssids"]  = e.bssids;
+    o["secure"]  = e.secure;
+  }
+  out.clear();
+  serializeJson(arr, out);
+  return !doc.overflowed();
+}
+#endif
+
+int main() {
+  const std::vector<ScanEntry> redes = escaneo(60);
+
+  std::string json;
+  const size_t bytes = conWriter(redes, &json);
+  CHECK(bytes == json.size());
+  CHECK(json.front() == '[' && json.back() == ']');
+  CHECK(json.find("{\"ssid\":\"Casa \\\"Ayres\\\" 5G\",\"rssi\":-37,\"channel\":8,"
+                  "\"bssids\":2,\"secure\":true}") != std::string::npos);
+  CHECK(json.find("\"oficina\\\\piso\\t2\"") != std::string::npos);
+  CHECK(json.find("\"Café ñandú\"") != std::string::npos);
+
+  const size_t picoWriter = awmPicoHeap([&] { conWriter(redes); });
+  CHECK(picoWriter == 0);                          // solo el buffer en stack
+  const double usWriter = awmMedirUs(2000, [&] { conWriter(redes); });
+  std::printf("  60 redes, %zu B: AwmJsonWriter heap %zu B (+%d B de stack), %.1f us\n",
+              bytes, picoWriter, AWM_JSON_CHUNK, usWriter);
+
+#if AWM_TEST_ARDUINOJSON
+  std::string viejo;
+  CHECK(conArduinoJson(redes, viejo));
+  CHECK(viejo == json);                            // mismo cuerpo byte a byte
+
+  std::string cache;                               // lastScanJson
+  const size_t picoDoc = awmPicoHeap([&] {
+    std::string out;
+    CHECK(conArduinoJson(redes, out));
+    cache.swap(out);
+  });
+  const double usDoc = awmMedirUs(2000, [&] { std::string out; conArduinoJson(redes, out); });
+  std::printf("  60 redes, %zu B: DynamicJsonDocument heap %zu B (%zu B quedan en cache), %.1f us\n",
+              viejo.size(), picoDoc, cache.capacity(), usDoc);
+  CHECK(picoDoc > bytes);
+#else
+  std::printf("  (sin ArduinoJson: no se compara con DynamicJsonDocument; "
+              "make ARDUINOJSON=<ruta a ArduinoJson/src>)\n");
+#endif
+
+  return awmResumen("test_scan_json");
+}
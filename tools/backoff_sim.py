@@ -0,0 +1,154 @@
+"""
+AyresWiFiManager — simulación del backoff de reconexión
+---------------------------------------------------------------
+Reproduce en la PC el cálculo de src/AWM_Backoff.h (FNV-1a de la MAC →
+xorshift32, espera min(cap, base·mult^n) con jitter) y la estrategia de
+estrategiaCaida(): N equipos pierden el router en t=0, el AP vuelve a los
+--outage segundos y acepta como mucho --ap-capacity asociaciones por segundo;
+los que no entran fallan y vuelven a esperar. La espera corre desde el fallo
+(fin del barrido o de la ventana del intento), como en
+reintentarConexionSiNecesario().
+
+La librería apaga el auto-reconnect del driver para que los reintentos sean
+solo los del backoff. --driver-retry N simula dejarlo encendido: el driver
+reasocia N segundos después de cada fallo aunque el backoff pida esperar más.
+
+Muestra cuántos intentos de asociación caen en cada franja de tiempo desde
+que vuelve el AP y cuánto tarda el último equipo en reconectar. Con
+--compare se corre además la misma caída con jitter 0 (todos en fase).
+
+Uso
+  python tools/backoff_sim.py [--devices 200] [--base 10] [--mult 2]
+                              [--cap 300] [--jitter 50] [--outage 60]
+                              [--ap-capacity 20] [--bucket 5] [--compare]
+                              [--driver-retry 0]
+
+Tiempos en segundos. Las MAC simuladas son consecutivas (24:0a:c4:00:xx:xx),
+el peor caso para un sembrado ingenuo.
+"""
+
+import argparse
+
+MASK = 0xFFFFFFFF
+NO_AP_FAIL_S = 2      # begin() sin AP: el driver informa NO_AP_FOUND tras un barrido
+ATTEMPT_S    = 5      # ventana por intento (setReconnectAttemptMs por defecto)
+
+
+class Backoff:
+    """Mismo cálculo que AwmBackoff (src/AWM_Backoff.h)."""
+
+    def __init__(self, base_ms, mult, cap_ms, jitter_pct, mac):
+        self.base = max(base_ms, 1)
+        self.mult = max(mult, 1.0)
+        self.cap = max(cap_ms, self.base)
+        self.jitter = min(jitter_pct, 100)
+        h = 2166136261
+        for b in mac:
+            h = ((h ^ b) * 16777619) & MASK
+        self.rnd = h or 0x9E3779B9
+        self.reset()
+
+    def reset(self):
+        self.cur = self.base
+
+    def _aleatorio(self):
+        r = self.rnd
+        r ^= (r << 13) & MASK
+        r ^= r >> 17
+        r ^= (r << 5) & MASK
+        self.rnd = r
+        return r
+
+    def next(self):
+        d = self.cur
+        sig = d * self.mult
+        self.cur = self.cap if sig >= self.cap else int(sig)
+        j = d * self.jitter // 100
+        return d - j + self._aleatorio() % (j + 1) if j else d
+
+
+def siguiente(args, fallo, espera):
+    """Inicio del próximo intento tras un fallo en `fallo` con la espera del backoff."""
+    if args.driver_retry > 0:
+        espera = min(espera, args.driver_retry)
+    return fallo + espera
+
+
+def simular(args, jitter):
+    """Devuelve (inicios de intentos con el AP arriba, segundo de reconexión por equipo)."""
+    equipos = []
+    for i in range(args.devices):
+        mac = (0x24, 0x0A, 0xC4, 0x00, (i >> 8) & 0xFF, i & 0xFF)
+        b = Backoff(int(args.base * 1000), args.mult, int(args.cap * 1000), jitter, mac)
+        # Caída por beacons perdidos: primer reintento sin espera (estrategiaCaida)
+        equipos.append({"b": b, "t": 0.0, "ok": None})
+
+    intentos = []
+    pendientes = list(range(args.devices))
+    while pendientes:
+        pendientes.sort(key=lambda k: equipos[k]["t"])
+        k = pendientes.pop(0)
+        e = equipos[k]
+        t = e["t"]
+        if t < args.outage:
+            # AP ausente: NO_AP, la espera avanza dos escalones
+            e["b"].next()
+            espera = e["b"].next() / 1000.0
+            e["t"] = siguiente(args, t + NO_AP_FAIL_S, espera)
+            pendientes.append(k)
+            continue
+
+        intentos.append(t)
+        seg = int(t)
+        usados = sum(1 for x in intentos if int(x) == seg) - 1
+        if usados < args.ap_capacity:
+            e["ok"] = t + 1
+        else:
+            # AP saturado: la ventana vence sin IP (OTHER), un escalón
+            espera = e["b"].next() / 1000.0
+            e["t"] = siguiente(args, t + ATTEMPT_S, espera)
+            pendientes.append(k)
+    return intentos, [e["ok"] for e in equipos]
+
+
+def informe(titulo, args, intentos, oks):
+    print("== %s ==" % titulo)
+    franjas = {}
+    for t in intentos:
+        f = int((t - args.outage) // args.bucket)
+        franjas[f] = franjas.get(f, 0) + 1
+    pico = max(franjas.values()) if franjas else 0
+    escala = max(1, pico // 50)
+    for f in range(0, (max(franjas) + 1) if franjas else 0):
+        n = franjas.get(f, 0)
+        if n:
+            print("  +%4ds  %4d  %s" % (f * args.bucket, n, "#" * max(1, n // escala)))
+    lat = sorted(t - args.outage for t in oks)
+    print("  intentos: %d para %d equipos · pico %d por %ds (AP: %d/s)"
+          % (len(intentos), args.devices, pico, args.bucket, args.ap_capacity))
+    print("  reconexión tras volver el AP: p50 %.0fs · p95 %.0fs · último %.0fs\n"
+          % (lat[len(lat) // 2], lat[int(len(lat) * 0.95) - 1], lat[-1]))
+
+
+def main():
+    p = argparse.ArgumentParser(description="Simula el backoff de reconexión de AyresWiFiManager")
+    p.add_argument("--devices", type=int, default=200)
+    p.add_argument("--base", type=float, default=10, help="segundos (setReconnectBackoffMs)")
+    p.add_argument("--mult", type=float, default=2.0)
+    p.add_argument("--cap", type=float, default=300, help="segundos")
+    p.add_argument("--jitter", type=int, default=50, help="porcentaje de la espera sorteado")
+    p.add_argument("--outage", type=float, default=60, help="segundos sin AP")
+    p.add_argument("--ap-capacity", type=int, default=20, help="asociaciones por segundo")
+    p.add_argument("--bucket", type=int, default=5, help="ancho de franja del histograma (s)")
+    p.add_argument("--compare", action="store_true", help="correr también con jitter 0")
+    p.add_argument("--driver-retry", type=float, default=0,
+                   help="segundos: auto-reconnect del driver encendido (0 = apagado, como la librería)")
+    args = p.parse_args()
+
+    if args.compare:
+        informe("jitter 0 (backoff fijo en fase)", args, *simular(args, 0))
+    informe("jitter %d%%" % args.jitter, args, *simular(args, args.jitter))
+
+
+if __name__ == "__main__":
+    main()
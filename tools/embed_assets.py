@@ -0,0 +1,148 @@
+"""
+AyresWiFiManager — portal embebido en flash
+---------------------------------------------------------------
+Convierte data/index.html, success.html y error.html en arrays PROGMEM
+(gzip por defecto) dentro de un header C++. Compilando con
+-D AWM_EMBED_PORTAL=1 el portal se sirve directo desde flash: sin
+LittleFS.exists()/open() por request y sin depender del montaje del FS.
+
+Uso
+  • PlatformIO (platformio.ini):
+        build_flags   = -D AWM_EMBED_PORTAL=1
+        extra_scripts = pre:tools/embed_assets.py
+    Regenera include/AWM_PortalAssets.h antes de compilar (solo si cambió).
+  • Manual:
+        python tools/embed_assets.py [--data data] [--out include/AWM_PortalAssets.h]
+                                     [--lang en] [--no-gzip]
+
+  --lang en   usa index_en.html / success_en.html / error_en.html si existen.
+  --no-gzip   embebe el HTML plano (más flash, sin Content-Encoding).
+
+El orden de la tabla coincide con las páginas del portal (index, success,
+error), así que la búsqueda es un índice directo.
+"""
+
+import argparse
+import gzip
+import io
+import os
+import re
+import sys
+
+PAGES = ("index.html", "success.html", "error.html")
+
+
+def _page_path(data_dir, page, lang):
+    if lang:
+        base, ext = os.path.splitext(page)
+        localized = os.path.join(data_dir, "%s_%s%s" % (base, lang, ext))
+        if os.path.exists(localized):
+            return localized
+    return os.path.join(data_dir, page)
+
+
+def _symbol(page):
+    return "AWM_ASSET_" + re.sub(r"[^0-9A-Za-z]", "_", page)
+
+
+def _fnv1a(blob):
+    """Mismo hash que hashArchivo() en AyresWiFiManager.cpp (ETag)."""
+    h = 2166136261
+    for b in blob:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h or 1
+
+
+def _gzip(raw):
+    buf = io.BytesIO()
+    with gzip.GzipFile(filename="", mode="wb", fileobj=buf, compresslevel=9, mtime=0) as gz:
+        gz.write(raw)
+    return buf.getvalue()
+
+
+def render(data_dir, lang=None, use_gzip=True):
+    out = [
+        "// Generado por tools/embed_assets.py — no editar a mano.",
+        "#pragma once",
+        "#include <Arduino.h>",
+        "",
+        "struct AwmEmbeddedAsset {",
+        "  const uint8_t* data;   // PROGMEM (nullptr si la página no existe)",
+        "  uint32_t       len;",
+        "  bool           gzip;",
+        "  uint32_t       etag;   // FNV-1a 32 del contenido servido",
+        "};",
+        "",
+    ]
+    rows = []
+    for page in PAGES:
+        src = _page_path(data_dir, page, lang)
+        if not os.path.exists(src):
+            print("[AWM] embed: falta %s, se servirá desde LittleFS" % src)
+            rows.append("  { nullptr, 0, false, 0 },  // %s" % page)
+            continue
+        with open(src, "rb") as f:
+            raw = f.read()
+        blob = _gzip(raw) if use_gzip else raw
+        sym = _symbol(page)
+        out.append("// %s (%d bytes -> %d)" % (os.path.basename(src), len(raw), len(blob)))
+        out.append("static const uint8_t %s[] PROGMEM = {" % sym)
+        for i in range(0, len(blob), 20):
+            out.append("  " + ",".join("0x%02x" % b for b in blob[i:i + 20]) + ",")
+        out.append("};")
+        out.append("")
+        rows.append("  { %s, sizeof(%s), %s, 0x%08xUL },  // %s" %
+                    (sym, sym, "true" if use_gzip else "false", _fnv1a(blob), page))
+        print("[AWM] embed: %s  %d -> %d bytes" % (os.path.basename(src), len(raw), len(blob)))
+
+    out.append("// Orden fijo: index, success, error (ver AyresWiFiManager::Pagina)")
+    out.append("static const AwmEmbeddedAsset AWM_PORTAL_ASSETS[] = {")
+    out.extend(rows)
+    out.append("};")
+    out.append("")
+    return "\n".join(out)
+
+
+def generate(data_dir, out_path, lang=None, use_gzip=True):
+    text = render(data_dir, lang, use_gzip)
+    if os.path.exists(out_path):
+        with open(out_path, "r", encoding="utf-8") as f:
+            if f.read() == text:
+                return
+    os.makedirs(os.path.dirname(out_path) or ".", exist_ok=True)
+    with open(out_path, "w", encoding="utf-8") as f:
+        f.write(text)
+    print("[AWM] embed: escrito %s" % out_path)
+
+
+def _embed_enabled(env):
+    for d in env.get("CPPDEFINES", []):
+        if isinstance(d, (list, tuple)):
+            name, value = d[0], (d[1] if len(d) > 1 else "1")
+        else:
+            name, _, value = str(d).partition("=")
+            value = value or "1"
+        if name == "AWM_EMBED_PORTAL" and str(value) != "0":
+            return True
+    return False
+
+
+try:
+    Import("env")  # noqa: F821 (inyectado por PlatformIO/SCons)
+except NameError:
+    env = None
+
+if env is not None:
+    if _embed_enabled(env):
+        generate(env.subst("$PROJECT_DATA_DIR"),
+                 os.path.join(env.subst("$PROJECT_INCLUDE_DIR"), "AWM_PortalAssets.h"),
+                 lang=os.environ.get("AWM_EMBED_LANG") or None)
+elif __name__ == "__main__":
+    ap = argparse.ArgumentParser(description="Embebe el portal AWM en flash")
+    ap.add_argument("--data", default="data")
+    ap.add_argument("--out", default=os.path.join("include", "AWM_PortalAssets.h"))
+    ap.add_argument("--lang", default=None)
+    ap.add_argument("--no-gzip", action="store_true")
+    a = ap.parse_args()
+    generate(a.data, a.out, a.lang, not a.no_gzip)
+    sys.exit(0)
@@ -0,0 +1,58 @@
+"""
+AyresWiFiManager — gzip de los archivos del portal
+---------------------------------------------------------------
+Genera un hermano .gz (index.html -> index.html.gz) por cada asset de texto
+de la carpeta data/, para que quede dentro de la imagen LittleFS. El portal
+sirve la variante comprimida con "Content-Encoding: gzip" cuando el navegador
+la acepta y cae al archivo plano en caso contrario.
+
+Uso
+  • PlatformIO (platformio.ini):
+        extra_scripts = pre:tools/gzip_assets.py
+    Se ejecuta solo en los targets buildfs / uploadfs.
+  • Manual:
+        python tools/gzip_assets.py [carpeta_data]
+
+La salida es reproducible (mtime=0) y solo se regenera si el original cambió.
+"""
+
+import gzip
+import os
+import sys
+
+EXTENSIONS = (".html", ".htm", ".css", ".js", ".json", ".svg", ".txt")
+
+
+def gzip_dir(data_dir):
+    if not os.path.isdir(data_dir):
+        print("[AWM] gzip: no existe %s, nada que hacer" % data_dir)
+        return
+    for root, _, files in os.walk(data_dir):
+        for name in files:
+            if not name.lower().endswith(EXTENSIONS):
+                continue
+            src = os.path.join(root, name)
+            dst = src + ".gz"
+            if os.path.exists(dst) and os.path.getmtime(dst) >= os.path.getmtime(src):
+                continue
+            with open(src, "rb") as f:
+                raw = f.read()
+            with open(dst, "wb") as f:
+                with gzip.GzipFile(filename="", mode="wb", fileobj=f,
+                                   compresslevel=9, mtime=0) as gz:
+                    gz.write(raw)
+            print("[AWM] gzip: %s  %d -> %d bytes" %
+                  (os.path.relpath(dst, data_dir), len(raw), os.path.getsize(dst)))
+
+
+try:
+    Import("env")  # noqa: F821 (inyectado por PlatformIO/SCons)
+except NameError:
+    env = None
+
+if env is not None:
+    FS_TARGETS = ("buildfs", "uploadfs", "uploadfsota")
+    if any(t in FS_TARGETS for t in COMMAND_LINE_TARGETS):  # noqa: F821
+        gzip_dir(env.subst("$PROJECT_DATA_DIR"))
+elif __name__ == "__main__":
+    gzip_dir(sys.argv[1] if len(sys.argv) > 1 else "data")
@@ -0,0 +1,107 @@
+"""
+AyresWiFiManager — servidor de prueba para el chequeo de Internet
+---------------------------------------------------------------
+Reemplaza en la LAN a clients3.google.com/generate_204 para ver cómo
+reacciona hayInternet() (y onInternetChange()) ante cada respuesta sin
+depender de la conexión real. El equipo apunta su sonda a la PC:
+
+    wifi.clearInternetProbes();
+    wifi.addInternetProbe("http://192.168.1.50:8080/generate_204");
+
+La respuesta la elige la ruta (/204, /200, /302, /503, /slow, /drop, /hang) o,
+para cualquier otra ruta, --mode:
+
+    204   No Content (Internet OK)
+    200   página HTML (portal cautivo que intercepta todo)
+    302   redirección a /login (portal cautivo típico)
+    503   Service Unavailable (destino que falla: sin Internet, no portal)
+    slow  204 tras --delay segundos (pasa o vence NET_TIMEOUT_MS = 3 s)
+    drop  acepta y cierra sin responder (la sonda informa "reply")
+    hang  acepta y no contesta nunca (la sonda informa "timeout")
+
+Uso
+  python tools/probe_standin.py [--port 8080] [--mode 204] [--delay 5]
+
+Cada request se muestra con la hora, la IP del equipo y lo que se respondió.
+"""
+
+import argparse
+import socketserver
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+MODOS = ("204", "200", "302", "503", "slow", "drop", "hang")
+
+
+class Sonda(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    modo = "204"
+    demora = 5.0
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def informar(self, texto):
+        print("%s  %-15s  %-22s → %s" % (time.strftime("%H:%M:%S"), self.client_address[0],
+                                         self.path, texto), flush=True)
+
+    def responder(self, codigo, cabeceras=(), cuerpo=b""):
+        self.send_response(codigo)
+        for k, v in cabeceras:
+            self.send_header(k, v)
+        self.send_header("Content-Length", str(len(cuerpo)))
+        self.send_header("Connection", "close")
+        self.informar(str(codigo))
+        try:
+            self.end_headers()
+            if cuerpo:
+                self.wfile.write(cuerpo)
+        except (ConnectionResetError, BrokenPipeError):
+            pass   # la sonda corta con RST apenas lee la línea de estado
+
+    def do_GET(self):
+        ruta = self.path.split("?")[0].strip("/")
+        modo = ruta if ruta in MODOS else self.modo
+        self.close_connection = True
+
+        if modo == "204":
+            self.responder(204)
+        elif modo == "200":
+            self.responder(200, [("Content-Type", "text/html")],
+                           b"<html><body><h1>Portal</h1>Acepte los terminos</body></html>")
+        elif modo == "302":
+            host = self.headers.get("Host", "portal")
+            self.responder(302, [("Location", "http://%s/login" % host)])
+        elif modo == "503":
+            self.responder(503)
+        elif modo == "slow":
+            time.sleep(self.demora)
+            self.responder(204)
+        elif modo == "drop":
+            self.informar("cerrada sin respuesta")
+        elif modo == "hang":
+            self.informar("sin respuesta (colgada)")
+            time.sleep(3600)
+
+
+def main():
+    p = argparse.ArgumentParser(description="Servidor generate_204 de prueba para AyresWiFiManager")
+    p.add_argument("--port", type=int, default=8080)
+    p.add_argument("--mode", choices=MODOS, default="204", help="respuesta para rutas sin modo")
+    p.add_argument("--delay", type=float, default=5.0, help="segundos de espera en modo slow")
+    args = p.parse_args()
+
+    Sonda.modo = args.mode
+    Sonda.demora = args.delay
+    socketserver.TCPServer.allow_reuse_address = True
+    ThreadingHTTPServer.daemon_threads = True
+    srv = ThreadingHTTPServer(("0.0.0.0", args.port), Sonda)
+    print("Escuchando en :%d (modo %s). Ctrl+C para salir." % (args.port, args.mode), flush=True)
+    try:
+        srv.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()